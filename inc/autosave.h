@@ -17,19 +17,22 @@ typedef enum {AS_START, AS_RESTART, AS_STOP, AS_SHUTDOWN} AS_event_type_t;
 typedef struct {
     AS_event_type_t type;
     int32_t sampleRate;
+    int32_t duration;
     int32_t currentIndex;
+    int32_t deviceName;
     int64_t currentCount;
     int64_t startTime;
     int64_t startCount;
-    char inputDeviceCommentName[DEVICE_NAME_SIZE];
 } AS_event_t;
 
 bool Autosave_initialise(int32_t number);
 
-bool Autosave_hasEvents(void);
+int32_t Autosave_internDeviceName(char *name);
 
-bool Autosave_getFirstEvent(AS_event_t *event);
+char *Autosave_getDeviceName(int32_t deviceName);
 
 bool Autosave_addEvent(AS_event_t *event);
 
-#endif /* __AUTOSAVE_H */
\ No newline at end of file
+int32_t Autosave_getEvents(AS_event_t *events, int32_t maximumNumberOfEvents);
+
+#endif /* __AUTOSAVE_H */
@@ -22,6 +22,19 @@ typedef struct {
     double A2_A0;
 } BQ_filterCoefficients_t;
 
+typedef struct {
+    int32_t xv[3];
+    int32_t yv[3];
+} BQ_fixedFilter_t;
+
+typedef struct {
+    int32_t B0_A0;
+    int32_t B1_A0;
+    int32_t B2_A0;
+    int32_t A1_A0;
+    int32_t A2_A0;
+} BQ_fixedFilterCoefficients_t;
+
 /* Public functions */
 
 void Biquad_designLowPassFilter(BQ_filterCoefficients_t *coefficients, uint32_t sampleRate, uint32_t frequency, double bandwidth);
@@ -32,8 +45,18 @@ void Biquad_designBandPassFilter(BQ_filterCoefficients_t *coefficients, uint32_t
 
 void Biquad_designNotchFilter(BQ_filterCoefficients_t *coefficients, uint32_t sampleRate, uint32_t frequency1, uint32_t frequency2);
 
+void Biquad_designBilinearFilter(BQ_filterCoefficients_t *coefficients, uint32_t sampleRate, double analogB0, double analogB1, double analogB2, double analogA0, double analogA1, double analogA2);
+
+double Biquad_getGain(BQ_filterCoefficients_t *coefficients, uint32_t sampleRate, double frequency);
+
 void Biquad_initialise(BQ_filter_t *filter);
 
 double Biquad_applyFilter(double sample, BQ_filter_t *filter, BQ_filterCoefficients_t *filterCoefficients);
 
+void Biquad_convertToFixedCoefficients(BQ_fixedFilterCoefficients_t *fixedCoefficients, BQ_filterCoefficients_t *coefficients);
+
+void Biquad_initialiseFixed(BQ_fixedFilter_t *filter);
+
+int32_t Biquad_applyFixedFilter(int32_t sample, BQ_fixedFilter_t *filter, BQ_fixedFilterCoefficients_t *filterCoefficients);
+
 #endif /* __BIQUAD_H */
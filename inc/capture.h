@@ -0,0 +1,66 @@
+/****************************************************************************
+ * capture.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __CAPTURE_H
+#define __CAPTURE_H
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+#define CAPTURE_INT16_SCALE     32768.0
+
+/* The int16 buffer holds the first channel. Without it the interleaved float buffer is the only copy and the int16 view is derived on read */
+
+typedef struct {
+    int16_t *buffer;
+    float *floatBuffer;
+    int32_t numberOfChannels;
+    int32_t bufferSize;
+    int32_t sampleRate;
+    int32_t writeIndex;
+    int64_t sampleCount;
+    int64_t startTime;
+    int64_t startCount;
+} CP_state_t;
+
+extern void Capture_getState(CP_state_t *state);
+
+static inline int16_t Capture_convertFloatSample(float sample) {
+
+    double value = round((double)sample * CAPTURE_INT16_SCALE);
+
+    return (int16_t)(value < INT16_MIN ? INT16_MIN : value > INT16_MAX ? INT16_MAX : value);
+
+}
+
+static inline void Capture_copySamples(CP_state_t *state, int32_t index, int32_t numberOfSamples, int16_t *destination) {
+
+    if (state->buffer != NULL) {
+
+        /* Split the copy where it wraps around the end of the ring */
+
+        int32_t numberOfSamples1 = numberOfSamples < state->bufferSize - index ? numberOfSamples : state->bufferSize - index;
+
+        memcpy(destination, state->buffer + index, numberOfSamples1 * sizeof(int16_t));
+
+        memcpy(destination + numberOfSamples1, state->buffer, (numberOfSamples - numberOfSamples1) * sizeof(int16_t));
+
+        return;
+
+    }
+
+    for (int32_t i = 0; i < numberOfSamples; i += 1) {
+
+        destination[i] = Capture_convertFloatSample(state->floatBuffer[(size_t)index * state->numberOfChannels]);
+
+        index = index + 1 == state->bufferSize ? 0 : index + 1;
+
+    }
+
+}
+
+#endif /* __CAPTURE_H */
@@ -0,0 +1,28 @@
+/****************************************************************************
+ * control.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __CONTROL_H
+#define __CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CONTROL_RESPONSE_SIZE   256
+
+typedef enum {CT_SAMPLE_RATE, CT_HETERODYNE, CT_MONITOR, CT_AUTOSAVE, CT_STATUS} CT_command_type_t;
+
+typedef struct {
+    CT_command_type_t type;
+    int32_t value;
+} CT_command_t;
+
+typedef bool (*CT_handler_t)(CT_command_t *command, char *response);
+
+bool Control_initialise(const char *path, CT_handler_t handler);
+
+void Control_close(void);
+
+#endif /* __CONTROL_H */
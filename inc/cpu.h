@@ -0,0 +1,44 @@
+/****************************************************************************
+ * cpu.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __CPU_H
+#define __CPU_H
+
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define IS_X86 true
+#else
+    #define IS_X86 false
+#endif
+
+#if defined(__aarch64__) || defined(__arm__)
+    #define IS_ARM true
+#else
+    #define IS_ARM false
+#endif
+
+#if defined(_MSC_VER)
+    #define CPU_TARGET(isa)
+#else
+    #define CPU_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/* NEON is optional on 32-bit ARM so its kernels are built for it separately from the rest of the program */
+
+#if defined(__arm__) && !defined(__ARM_NEON)
+    #define CPU_NEON_TARGET CPU_TARGET("fpu=neon")
+#else
+    #define CPU_NEON_TARGET
+#endif
+
+typedef enum {CPU_GENERIC, CPU_SSE2, CPU_AVX2, CPU_AVX512, CPU_NEON} CPU_instructionSet_t;
+
+CPU_instructionSet_t CPU_getInstructionSet(void);
+
+char *CPU_getInstructionSetName(CPU_instructionSet_t instructionSet);
+
+#endif /* __CPU_H */
@@ -0,0 +1,16 @@
+/****************************************************************************
+ * frequencyDivision.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __FREQUENCY_DIVISION_H
+#define __FREQUENCY_DIVISION_H
+
+#include <stdint.h>
+
+void FrequencyDivision_initialise(int32_t sampleRate, int32_t divisionRatio);
+
+double FrequencyDivision_nextOutput(double sample);
+
+#endif /* __FREQUENCY_DIVISION_H */
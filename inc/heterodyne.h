@@ -17,4 +17,8 @@ double Heterodyne_nextOutput(double sample);
 
 void Heterodyne_normalise(void);
 
+int32_t Heterodyne_nextFixedOutput(int32_t sample);
+
+void Heterodyne_normaliseFixed(void);
+
 #endif /* __HETERO_H */
\ No newline at end of file
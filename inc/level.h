@@ -0,0 +1,42 @@
+/****************************************************************************
+ * level.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __LEVEL_H
+#define __LEVEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+typedef struct {
+    double peak;
+    double sumOfSquares;
+    int64_t numberOfSamples;
+    int64_t clippedSamples;
+} LV_levels_t;
+
+void Level_setInstructionSet(CPU_instructionSet_t instructionSet);
+
+void Level_reset(LV_levels_t *levels);
+
+void Level_combine(LV_levels_t *levels, LV_levels_t *otherLevels);
+
+void Level_measure(LV_levels_t *levels, const void *samples, int32_t numberOfSamples, bool floatSamples);
+
+double Level_getPeakDecibels(LV_levels_t *levels);
+
+double Level_getRMSDecibels(LV_levels_t *levels);
+
+void Level_setBlockSize(int32_t numberOfSamples);
+
+void Level_process(const void *samples, int32_t numberOfSamples, bool floatSamples);
+
+bool Level_getLatestBlock(LV_levels_t *levels);
+
+int64_t Level_getClippedSamples(void);
+
+#endif /* __LEVEL_H */
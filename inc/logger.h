@@ -0,0 +1,27 @@
+/****************************************************************************
+ * logger.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __LOGGER_H
+#define __LOGGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {LG_HUMAN, LG_JSON} LG_format_t;
+
+typedef enum {LG_INFO, LG_WARNING, LG_ERROR} LG_level_t;
+
+typedef enum {LG_AUTOSAVE, LG_CAPTURE, LG_PLAYBACK, LG_RECOVERY, LG_RETENTION, LG_STREAM, LG_LOGGER, LG_NUMBER_OF_SUBSYSTEMS} LG_subsystem_t;
+
+bool Logger_initialise(LG_format_t format);
+
+void Logger_log(LG_level_t level, LG_subsystem_t subsystem, const char *format, ...);
+
+void Logger_setStatusWidth(int32_t width);
+
+void Logger_close(void);
+
+#endif /* __LOGGER_H */
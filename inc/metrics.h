@@ -0,0 +1,41 @@
+/****************************************************************************
+ * metrics.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __METRICS_H
+#define __METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define METRICS_RATIO_SCALE     1000000
+#define METRICS_DECIBEL_SCALE   1000
+
+typedef enum {
+    MT_SAMPLES_CAPTURED,
+    MT_SAMPLES_WRITTEN,
+    MT_FILES_WRITTEN,
+    MT_RING_FILL,
+    MT_WRITER_LAG,
+    MT_FILE_WRITE_LATENCY,
+    MT_RESTARTS_TIME_MISMATCH,
+    MT_RESTARTS_DEVICE_CHANGE,
+    MT_ENUMERATION_TIME,
+    MT_PLAYBACK_STARVATIONS,
+    MT_STREAM_DROPPED_SAMPLES,
+    MT_NETWORK_DROPPED_SAMPLES,
+    MT_PEAK_LEVEL,
+    MT_RMS_LEVEL,
+    MT_CLIPPED_SAMPLES,
+    MT_NUMBER_OF_METRICS
+} MT_metric_t;
+
+void Metrics_add(MT_metric_t metric, int64_t value);
+
+void Metrics_set(MT_metric_t metric, int64_t value);
+
+bool Metrics_initialise(const char *path);
+
+#endif /* __METRICS_H */
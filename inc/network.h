@@ -0,0 +1,17 @@
+/****************************************************************************
+ * network.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __NETWORK_H
+#define __NETWORK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {NT_TCP, NT_UDP} NT_protocol_t;
+
+bool Network_initialise(NT_protocol_t protocol, int32_t port, const char *bindAddress);
+
+#endif /* __NETWORK_H */
@@ -0,0 +1,28 @@
+/****************************************************************************
+ * persistentRing.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __PERSISTENT_RING_H
+#define __PERSISTENT_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    int32_t sampleRate;
+    int32_t startIndex;
+    int32_t numberOfSamples;
+    int64_t startTime;
+} PR_recovery_t;
+
+int16_t *PersistentRing_initialise(const char *path, int32_t bufferSize, PR_recovery_t *recovery);
+
+void PersistentRing_publish(int32_t sampleRate, int64_t sampleCount, int64_t startTime, int64_t startCount);
+
+void PersistentRing_setFlushedCount(int64_t flushedCount);
+
+void PersistentRing_sync(void);
+
+#endif /* __PERSISTENT_RING_H */
@@ -0,0 +1,28 @@
+/****************************************************************************
+ * queue.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __QUEUE_H
+#define __QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct QU_queue_t QU_queue_t;
+
+QU_queue_t *Queue_create(int32_t number, size_t itemSize);
+
+void *Queue_claim(QU_queue_t *queue, int64_t *position);
+
+void Queue_publish(QU_queue_t *queue, int64_t position);
+
+bool Queue_push(QU_queue_t *queue, const void *item);
+
+void *Queue_peek(QU_queue_t *queue);
+
+void Queue_release(QU_queue_t *queue);
+
+#endif /* __QUEUE_H */
@@ -0,0 +1,22 @@
+/****************************************************************************
+ * retention.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __RETENTION_H
+#define __RETENTION_H
+
+#include <time.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+bool Retention_initialise(const char *destination, int64_t maximumBytes, int64_t maximumAge, int64_t minimumFreeBytes, const char *archiveDestination);
+
+bool Retention_addFile(const char *filename, int64_t size, time_t startTime);
+
+void Retention_updateFile(const char *filename, int64_t additionalSize);
+
+bool Retention_enforce(time_t currentTime);
+
+#endif /* __RETENTION_H */
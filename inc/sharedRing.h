@@ -0,0 +1,19 @@
+/****************************************************************************
+ * sharedRing.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __SHARED_RING_H
+#define __SHARED_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+int16_t *SharedRing_initialise(const char *name, int32_t bufferSize);
+
+void SharedRing_publish(int32_t sampleRate, int32_t writeIndex, int64_t sampleCount, int64_t startTime, int64_t startCount);
+
+void SharedRing_close(void);
+
+#endif /* __SHARED_RING_H */
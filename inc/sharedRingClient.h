@@ -0,0 +1,141 @@
+/****************************************************************************
+ * sharedRingClient.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __SHARED_RING_CLIENT_H
+#define __SHARED_RING_CLIENT_H
+
+/* Header only reader for the audio buffer exported with SHAREDMEMORY <name> */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SHARED_RING_ID                  "AMLR"
+#define SHARED_RING_ID_LENGTH           4
+#define SHARED_RING_VERSION             1
+#define SHARED_RING_HEADER_SIZE         4096
+
+typedef struct {
+    char id[SHARED_RING_ID_LENGTH];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t bufferSize;
+    atomic_uint_least32_t sequence;
+    atomic_int_least32_t sampleRate;
+    atomic_int_least32_t writeIndex;
+    atomic_int_least64_t sampleCount;
+    atomic_int_least64_t startTime;
+    atomic_int_least64_t startCount;
+} SR_header_t;
+
+typedef struct {
+    int32_t sampleRate;
+    int32_t writeIndex;
+    int64_t sampleCount;
+    int64_t startTime;
+    int64_t startCount;
+} SR_state_t;
+
+typedef struct {
+    const SR_header_t *header;
+    const int16_t *buffer;
+    size_t size;
+} SR_client_t;
+
+/* Map the ring read only */
+
+static inline bool SharedRingClient_open(const char *name, SR_client_t *client) {
+
+    int file = shm_open(name, O_RDONLY, 0);
+
+    if (file < 0) return false;
+
+    struct stat status;
+
+    bool success = fstat(file, &status) == 0 && status.st_size >= SHARED_RING_HEADER_SIZE;
+
+    void *memory = success ? mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+
+    close(file);
+
+    if (memory == MAP_FAILED) return false;
+
+    const SR_header_t *header = (const SR_header_t*)memory;
+
+    if (memcmp(header->id, SHARED_RING_ID, SHARED_RING_ID_LENGTH) != 0 || header->version != SHARED_RING_VERSION) {
+
+        munmap(memory, status.st_size);
+
+        return false;
+
+    }
+
+    client->header = header;
+
+    client->buffer = (const int16_t*)((const char*)memory + header->headerSize);
+
+    client->size = status.st_size;
+
+    return true;
+
+}
+
+static inline void SharedRingClient_close(SR_client_t *client) {
+
+    munmap((void*)client->header, client->size);
+
+}
+
+/* Read a consistent snapshot of the write position */
+
+static inline void SharedRingClient_getState(const SR_client_t *client, SR_state_t *state) {
+
+    SR_header_t *header = (SR_header_t*)client->header;
+
+    uint32_t before, after;
+
+    do {
+
+        before = atomic_load_explicit(&header->sequence, memory_order_acquire);
+
+        state->sampleRate = atomic_load_explicit(&header->sampleRate, memory_order_relaxed);
+        state->writeIndex = atomic_load_explicit(&header->writeIndex, memory_order_relaxed);
+        state->sampleCount = atomic_load_explicit(&header->sampleCount, memory_order_relaxed);
+        state->startTime = atomic_load_explicit(&header->startTime, memory_order_relaxed);
+        state->startCount = atomic_load_explicit(&header->startCount, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+
+        after = atomic_load_explicit(&header->sequence, memory_order_relaxed);
+
+    } while (before != after || (before & 1));
+
+}
+
+/* Locate the sample with a given count, which is only valid while it is less than half a buffer behind as capture writes ahead of the published position */
+
+static inline int32_t SharedRingClient_getIndex(const SR_client_t *client, const SR_state_t *state, int64_t count) {
+
+    int64_t bufferSize = client->header->bufferSize;
+
+    return (int32_t)((bufferSize + state->writeIndex - (state->sampleCount - count) % bufferSize) % bufferSize);
+
+}
+
+static inline bool SharedRingClient_isValid(const SR_client_t *client, int64_t count) {
+
+    int64_t sampleCount = atomic_load_explicit(&((SR_header_t*)client->header)->sampleCount, memory_order_acquire);
+
+    return sampleCount - count < (int64_t)client->header->bufferSize / 2;
+
+}
+
+#endif /* __SHARED_RING_CLIENT_H */
@@ -0,0 +1,17 @@
+/****************************************************************************
+ * soundLevel.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __SOUND_LEVEL_H
+#define __SOUND_LEVEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+bool SoundLevel_initialise(const char *path);
+
+void SoundLevel_close(void);
+
+#endif /* __SOUND_LEVEL_H */
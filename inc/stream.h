@@ -0,0 +1,29 @@
+/****************************************************************************
+ * stream.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __STREAM_H
+#define __STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STREAM_ID_LENGTH        4
+
+#pragma pack(push, 1)
+
+typedef struct {
+    char id[STREAM_ID_LENGTH];
+    uint32_t sampleRate;
+    uint32_t numberOfSamples;
+    int64_t sampleCount;
+    int64_t timestamp;
+} ST_frameHeader_t;
+
+#pragma pack(pop)
+
+bool Stream_initialise(const char *path);
+
+#endif /* __STREAM_H */
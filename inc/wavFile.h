@@ -10,10 +10,21 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "cpu.h"
+
 #define RIFF_ID_LENGTH                          4
 #define LENGTH_OF_ARTIST                        32
 #define LENGTH_OF_COMMENT                       384
 #define NUMBER_OF_BYTES_IN_SAMPLE               2
+#define LENGTH_OF_GUID                          16
+
+typedef enum {WAV_FLAT_LAYOUT, WAV_DAILY_LAYOUT, WAV_HOURLY_LAYOUT} WAV_directoryLayout_t;
+
+typedef enum {WAV_SYNC_NONE, WAV_SYNC_APPEND, WAV_SYNC_INTERVAL} WAV_durability_t;
+
+typedef enum {WAV_INT16, WAV_INT24, WAV_FLOAT32} WAV_sampleFormat_t;
+
+typedef enum {WAV_STDIO_WRITER, WAV_MAPPED_WRITER, WAV_DIRECT_WRITER, WAV_DONTNEED_WRITER} WAV_writer_t;
 
 #pragma pack(push, 1)
 
@@ -41,11 +52,19 @@ typedef struct {
     uint16_t bitsPerSample;
 } wavFormat_t;
 
+typedef struct {
+    uint16_t size;
+    uint16_t validBitsPerSample;
+    uint32_t channelMask;
+    uint8_t subFormat[LENGTH_OF_GUID];
+} wavFormatExtension_t;
+
 typedef struct {
     chunk_t riff;
     char format[RIFF_ID_LENGTH];
     chunk_t fmt;
     wavFormat_t wavFormat;
+    wavFormatExtension_t extension;
     chunk_t list;
     char info[RIFF_ID_LENGTH];
     icmt_t icmt;
@@ -61,10 +80,28 @@ void WavFile_setHeaderDetails(WAV_header_t *header, uint32_t sampleRate, uint32_
 
 void WavFile_setHeaderComment(WAV_header_t *header, int32_t currentTime, int32_t milliseconds, int32_t timeOffset, char *deviceName);
 
-void WavFile_setFilename(char *filename, int32_t currentTime,int32_t milliseconds, char *fileDestination);
+void WavFile_addHeaderLevels(WAV_header_t *header, double peakLevel, double rmsLevel, int64_t clippedSamples);
+
+void WavFile_setFilename(char *filename, int32_t currentTime, int32_t milliseconds, char *fileDestination, WAV_directoryLayout_t layout);
+
+bool WavFile_writeFile(WAV_header_t *header, char *filename, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2, int32_t numberOfSamplesToPreallocate);
+
+bool WavFile_appendFile(char *filename, char *comment, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2);
+
+bool WavFile_releaseFile(char *filename);
+
+void WavFile_setDurability(WAV_durability_t durability, int32_t interval);
+
+void WavFile_setWriter(WAV_writer_t writer);
+
+void WavFile_setSampleFormats(WAV_sampleFormat_t bufferFormat, WAV_sampleFormat_t fileFormat, int32_t numberOfChannels);
+
+void WavFile_setInstructionSet(CPU_instructionSet_t instructionSet);
+
+int32_t WavFile_getHeaderSize(void);
 
-bool WavFile_writeFile(WAV_header_t *header, char *filename, int16_t *buffer1, int32_t numberOfSamples1, int16_t *buffer2, int32_t numberOfSamples2);
+int32_t WavFile_getBytesPerFrame(void);
 
-bool WavFile_appendFile(char *filename, int16_t *buffer1, int32_t numberOfSamples1, int16_t *buffer2, int32_t numberOfSamples2);
+bool WavFile_repairFile(char *filename, int64_t length, bool *repaired);
 
 #endif /* __WAV_FILE_H */
\ No newline at end of file
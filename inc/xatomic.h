@@ -0,0 +1,67 @@
+/****************************************************************************
+ * xatomic.h
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#ifndef __XATOMIC_H
+#define __XATOMIC_H
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+    /* The Microsoft compiler only provides C11 atomics behind experimental flags so the subset used here is mapped onto the Interlocked functions. These are full barriers so every memory order is honoured */
+
+    #include <stdint.h>
+    #include <stdbool.h>
+    #include <windows.h>
+
+    typedef enum {memory_order_relaxed, memory_order_consume, memory_order_acquire, memory_order_release, memory_order_acq_rel, memory_order_seq_cst} memory_order;
+
+    typedef volatile LONG atomic_int;
+    typedef volatile LONG atomic_bool;
+    typedef volatile LONG atomic_uint_least32_t;
+    typedef volatile LONG atomic_int_least32_t;
+    typedef volatile LONG64 atomic_int_least64_t;
+    typedef volatile LONG64 atomic_int_fast64_t;
+
+    #define IS_ATOMIC_64(object)                                        (sizeof(*(object)) == sizeof(LONG64))
+
+    #define atomic_init(object, value)                                  (*(object) = (value))
+
+    #define atomic_load_explicit(object, order)                         (IS_ATOMIC_64(object) ? InterlockedOr64((volatile LONG64*)(object), 0) : InterlockedOr((volatile LONG*)(object), 0))
+
+    #define atomic_store_explicit(object, value, order)                 (IS_ATOMIC_64(object) ? (void)InterlockedExchange64((volatile LONG64*)(object), (LONG64)(value)) : (void)InterlockedExchange((volatile LONG*)(object), (LONG)(value)))
+
+    #define atomic_exchange_explicit(object, value, order)              (IS_ATOMIC_64(object) ? InterlockedExchange64((volatile LONG64*)(object), (LONG64)(value)) : InterlockedExchange((volatile LONG*)(object), (LONG)(value)))
+
+    #define atomic_fetch_add_explicit(object, value, order)             (IS_ATOMIC_64(object) ? InterlockedExchangeAdd64((volatile LONG64*)(object), (LONG64)(value)) : InterlockedExchangeAdd((volatile LONG*)(object), (LONG)(value)))
+
+    #define atomic_load(object)                                         atomic_load_explicit(object, memory_order_seq_cst)
+
+    #define atomic_store(object, value)                                 atomic_store_explicit(object, value, memory_order_seq_cst)
+
+    #define atomic_thread_fence(order)                                  MemoryBarrier()
+
+    /* Compare and exchange is only used on 64-bit positions */
+
+    #define atomic_compare_exchange_weak_explicit(object, expected, desired, success, failure) compareExchange64(object, expected, desired)
+
+    static inline bool compareExchange64(volatile LONG64 *object, int64_t *expected, int64_t desired) {
+
+        LONG64 previous = InterlockedCompareExchange64(object, desired, *expected);
+
+        bool exchanged = previous == *expected;
+
+        *expected = previous;
+
+        return exchanged;
+
+    }
+
+#else
+
+    #include <stdatomic.h>
+
+#endif
+
+#endif /* __XATOMIC_H */
@@ -7,8 +7,11 @@
 #ifndef __XDIRECTORY_H
 #define __XDIRECTORY_H
 
+#include <stdio.h>
 #include <stdbool.h>
 
 bool Directory_exists(const char *path);
 
+FILE *Directory_openFile(const char *path, const char *mode);
+
 #endif /* __XDIRECTORY_H */
\ No newline at end of file
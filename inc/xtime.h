@@ -14,6 +14,8 @@ uint32_t Time_getMicroseconds(void);
 
 int64_t Time_getMillisecondUTC(void);
 
+int64_t Time_getMonotonicMicroseconds(void);
+
 void Time_gmTime(const time_t *timer, struct tm *buf);
 
 int32_t Time_getLocalTimeOffset(void);
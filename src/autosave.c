@@ -9,116 +9,96 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "threads.h"
+#include "queue.h"
 #include "autosave.h"
+#include "xatomic.h"
 
-/* Global queue variables */
+/* Global queue variable */
 
-static int32_t readIndex;
+static QU_queue_t *queue;
 
-static int32_t writeIndex;
+/* Interned device name variables */
 
-static AS_event_t* events;
+static int32_t capacity;
 
-static pthread_mutex_t mutex;
+static char (*deviceNames)[DEVICE_NAME_SIZE];
 
-static int32_t numberOfEvents;
+static atomic_int nextDeviceName;
+
+static atomic_int latestDeviceName;
 
 /* Public functions */
 
 bool Autosave_initialise(int32_t number) {
 
-    pthread_mutex_init(&mutex, NULL);
-
-    pthread_mutex_lock(&mutex);
-    
-    events = (AS_event_t*)calloc(number, sizeof(AS_event_t));
-
-    numberOfEvents = number;
+    queue = Queue_create(number, sizeof(AS_event_t));
 
-    writeIndex = 0;
+    /* Keep at least as many names as queue slots, which are rounded up to a power of two */
 
-    readIndex = 0;
+    capacity = 1;
 
-    pthread_mutex_unlock(&mutex);
+    while (capacity < number) capacity *= 2;
 
-    return events != NULL;
-
-}
+    deviceNames = calloc(capacity, DEVICE_NAME_SIZE);
 
-bool Autosave_hasEvents(void) {
+    if (queue == NULL || deviceNames == NULL) return false;
 
-    pthread_mutex_lock(&mutex);
+    atomic_init(&nextDeviceName, 1);
 
-    bool hasEvents = readIndex != writeIndex;
+    atomic_init(&latestDeviceName, 0);
 
-    pthread_mutex_unlock(&mutex);
+    return true;
 
-    return hasEvents;
-    
 }
 
-bool Autosave_getFirstEvent(AS_event_t *event) {
+int32_t Autosave_internDeviceName(char *name) {
 
-    pthread_mutex_lock(&mutex);
+    /* Names change rarely so only the most recent one is compared */
 
-    bool contents = readIndex != writeIndex;
+    int32_t latest = atomic_load_explicit(&latestDeviceName, memory_order_acquire);
 
-    if (contents) {
-        
-        memcpy(event, events + readIndex, sizeof(AS_event_t));
+    if (strcmp(deviceNames[latest], name) == 0) return latest;
 
-        readIndex = (readIndex + 1) % numberOfEvents;
-    }
+    /* A slot is only reused after every other slot, and so every queued event, has moved on */
 
-    pthread_mutex_unlock(&mutex);
+    int32_t index = atomic_fetch_add_explicit(&nextDeviceName, 1, memory_order_relaxed) % capacity;
 
-    return contents;
+    strncpy(deviceNames[index], name, DEVICE_NAME_SIZE - 1);
 
-}
+    atomic_store_explicit(&latestDeviceName, index, memory_order_release);
 
-bool Autosave_addEvent(AS_event_t *event) {
+    return index;
 
-    pthread_mutex_lock(&mutex);
+}
 
-    if ((writeIndex + 1) % numberOfEvents == readIndex) {
+char *Autosave_getDeviceName(int32_t deviceName) {
 
-        AS_event_t *newEvents = (AS_event_t*)calloc(2 * numberOfEvents, sizeof(AS_event_t));
+    return deviceNames[deviceName];
 
-        if (newEvents == NULL) {
-            
-            pthread_mutex_unlock(&mutex);
+}
 
-            return false;
+bool Autosave_addEvent(AS_event_t *event) {
 
-        }
-        
-        memcpy(newEvents, events + readIndex, (numberOfEvents - readIndex) * sizeof(AS_event_t));
+    return Queue_push(queue, event);
 
-        if (writeIndex < readIndex) {
+}
 
-            memcpy(newEvents + numberOfEvents - readIndex, events, (writeIndex + 1) * sizeof(AS_event_t));
+int32_t Autosave_getEvents(AS_event_t *events, int32_t maximumNumberOfEvents) {
 
-            writeIndex = numberOfEvents - 1;
+    int32_t numberOfEvents = 0;
 
-            readIndex = 0;
+    AS_event_t *event;
 
-        }
+    while (numberOfEvents < maximumNumberOfEvents && (event = (AS_event_t*)Queue_peek(queue)) != NULL) {
 
-        free(events);
+        memcpy(events + numberOfEvents, event, sizeof(AS_event_t));
 
-        events = newEvents;
+        Queue_release(queue);
 
-        numberOfEvents *= 2;
+        numberOfEvents += 1;
 
     }
 
-    memcpy(events + writeIndex, event, sizeof(AS_event_t));
-
-    writeIndex = (writeIndex + 1) % numberOfEvents;
-
-    pthread_mutex_unlock(&mutex);
-
-    return true;
+    return numberOfEvents;
 
 }
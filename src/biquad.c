@@ -18,6 +18,11 @@
 #define M_TWOPI         (2.0 * M_PI)
 #endif
 
+/* Fixed point constants with coefficients in Q30 so values up to two in magnitude fit */
+
+#define COEFFICIENT_FRACTIONAL_BITS     30
+#define COEFFICIENT_ROUNDING            (1LL << (COEFFICIENT_FRACTIONAL_BITS - 1))
+
 /* Private functions to determine initial parameters and set final coefficients */
 
 static inline void determineParametersFromFrequencyAndBandwidth(uint32_t frequency, double bandwidth, uint32_t sampleRate, double *omega, double *alpha) {
@@ -124,6 +129,40 @@ void Biquad_designNotchFilter(BQ_filterCoefficients_t *coefficients, uint32_t sa
 
 }
 
+/* Public function to map an analog section (b0 s^2 + b1 s + b2) / (a0 s^2 + a1 s + a2) with the bilinear transform */
+
+void Biquad_designBilinearFilter(BQ_filterCoefficients_t *coefficients, uint32_t sampleRate, double analogB0, double analogB1, double analogB2, double analogA0, double analogA1, double analogA2) {
+
+    double k = 2.0 * (double)sampleRate;
+
+    double b0 = analogB0 * k * k + analogB1 * k + analogB2;
+    double b1 = 2.0 * (analogB2 - analogB0 * k * k);
+    double b2 = analogB0 * k * k - analogB1 * k + analogB2;
+
+    double a0 = analogA0 * k * k + analogA1 * k + analogA2;
+    double a1 = 2.0 * (analogA2 - analogA0 * k * k);
+    double a2 = analogA0 * k * k - analogA1 * k + analogA2;
+
+    setFilterCoefficients(coefficients, b0, b1, b2, a0, a1, a2);
+
+}
+
+/* Public function to determine the gain of a filter at a frequency */
+
+double Biquad_getGain(BQ_filterCoefficients_t *coefficients, uint32_t sampleRate, double frequency) {
+
+    double omega = M_TWOPI * frequency / (double)sampleRate;
+
+    double numeratorReal = coefficients->B0_A0 + coefficients->B1_A0 * cos(omega) + coefficients->B2_A0 * cos(2.0 * omega);
+    double numeratorImaginary = -coefficients->B1_A0 * sin(omega) - coefficients->B2_A0 * sin(2.0 * omega);
+
+    double denominatorReal = 1.0 + coefficients->A1_A0 * cos(omega) + coefficients->A2_A0 * cos(2.0 * omega);
+    double denominatorImaginary = -coefficients->A1_A0 * sin(omega) - coefficients->A2_A0 * sin(2.0 * omega);
+
+    return sqrt((numeratorReal * numeratorReal + numeratorImaginary * numeratorImaginary) / (denominatorReal * denominatorReal + denominatorImaginary * denominatorImaginary));
+
+}
+
 /* Public functions to initialise and apply filters */
 
 void Biquad_initialise(BQ_filter_t *filter) {
@@ -149,3 +188,43 @@ double Biquad_applyFilter(double sample, BQ_filter_t *filter, BQ_filterCoefficie
     return filter->yv[2];
 
 }
+
+/* Public functions to convert and apply fixed point filters */
+
+void Biquad_convertToFixedCoefficients(BQ_fixedFilterCoefficients_t *fixedCoefficients, BQ_filterCoefficients_t *coefficients) {
+
+    double scale = (double)(1LL << COEFFICIENT_FRACTIONAL_BITS);
+
+    fixedCoefficients->A1_A0 = (int32_t)lround(coefficients->A1_A0 * scale);
+    fixedCoefficients->A2_A0 = (int32_t)lround(coefficients->A2_A0 * scale);
+    fixedCoefficients->B0_A0 = (int32_t)lround(coefficients->B0_A0 * scale);
+    fixedCoefficients->B1_A0 = (int32_t)lround(coefficients->B1_A0 * scale);
+    fixedCoefficients->B2_A0 = (int32_t)lround(coefficients->B2_A0 * scale);
+
+}
+
+void Biquad_initialiseFixed(BQ_fixedFilter_t *filter) {
+
+    for (int i = 0; i < 3; i += 1) {
+        filter->xv[i] = 0;
+        filter->yv[i] = 0;
+    }
+
+}
+
+int32_t Biquad_applyFixedFilter(int32_t sample, BQ_fixedFilter_t *filter, BQ_fixedFilterCoefficients_t *filterCoefficients) {
+
+    for (int i = 0; i < 2; i += 1) {
+        filter->xv[i] = filter->xv[i+1];
+        filter->yv[i] = filter->yv[i+1];
+    }
+
+    filter->xv[2] = sample;
+
+    int64_t accumulator = (int64_t)filterCoefficients->B0_A0 * filter->xv[2] + (int64_t)filterCoefficients->B1_A0 * filter->xv[1] + (int64_t)filterCoefficients->B2_A0 * filter->xv[0] - (int64_t)filterCoefficients->A1_A0 * filter->yv[1] - (int64_t)filterCoefficients->A2_A0 * filter->yv[0];
+
+    filter->yv[2] = (int32_t)((accumulator + COEFFICIENT_ROUNDING) >> COEFFICIENT_FRACTIONAL_BITS);
+
+    return filter->yv[2];
+
+}
@@ -0,0 +1,250 @@
+/****************************************************************************
+ * control.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threads.h"
+#include "control.h"
+
+/* Protocol constants */
+
+#define LINE_BUFFER_SIZE        256
+#define KEYWORD_BUFFER_SIZE     32
+#define STATUS_BUFFER_SIZE      8
+
+/* Private function to parse a command line */
+
+static bool parseCommand(char *line, CT_command_t *command) {
+
+    char keyword[KEYWORD_BUFFER_SIZE];
+
+    char argument[KEYWORD_BUFFER_SIZE];
+
+    int32_t count = sscanf(line, "%31s %31s", keyword, argument);
+
+    if (count < 1) return false;
+
+    for (char *character = keyword; *character; character += 1) *character = toupper(*character);
+
+    for (char *character = argument; count == 2 && *character; character += 1) *character = toupper(*character);
+
+    if (strcmp(keyword, "STATUS") == 0) {
+
+        command->type = CT_STATUS;
+
+        command->value = 0;
+
+        return count == 1;
+
+    }
+
+    if (count != 2) return false;
+
+    if (strcmp(keyword, "MONITOR") == 0) {
+
+        command->type = CT_MONITOR;
+
+        if (strcmp(argument, "ON") == 0) command->value = 1;
+        
+        else if (strcmp(argument, "OFF") == 0) command->value = 0;
+        
+        else return false;
+
+        return true;
+
+    }
+
+    for (char *character = argument; *character; character += 1) {
+
+        if (*character < '0' || *character > '9') return false;
+
+    }
+
+    command->value = atoi(argument);
+
+    if (strcmp(keyword, "SAMPLERATE") == 0) command->type = CT_SAMPLE_RATE;
+
+    else if (strcmp(keyword, "HETERODYNE") == 0) command->type = CT_HETERODYNE;
+
+    else if (strcmp(keyword, "AUTOSAVE") == 0) command->type = CT_AUTOSAVE;
+
+    else return false;
+
+    return true;
+
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    bool Control_initialise(const char *path, CT_handler_t handler) {
+
+        return false;
+
+    }
+
+    void Control_close(void) { }
+
+#else
+
+    #include <unistd.h>
+    #include <sys/un.h>
+    #include <sys/socket.h>
+
+    #ifndef MSG_NOSIGNAL
+        #define MSG_NOSIGNAL 0
+    #endif
+
+    /* Socket variables */
+
+    static int serverSocket = -1;
+
+    static pthread_t controlThread;
+
+    static struct sockaddr_un address;
+
+    static CT_handler_t commandHandler;
+
+    /* Private functions to serve a client */
+
+    static void sendResponse(int clientSocket, char *response) {
+
+        send(clientSocket, response, strlen(response), MSG_NOSIGNAL);
+
+    }
+
+    static void serveClient(int clientSocket) {
+
+        static char line[LINE_BUFFER_SIZE];
+
+        static char text[CONTROL_RESPONSE_SIZE];
+
+        static char response[STATUS_BUFFER_SIZE + CONTROL_RESPONSE_SIZE];
+
+        int32_t length = 0;
+
+        bool overflow = false;
+
+        char character;
+
+        while (recv(clientSocket, &character, 1, 0) == 1) {
+
+            if (character == '\r') continue;
+
+            if (character != '\n') {
+
+                if (length < LINE_BUFFER_SIZE - 1) line[length++] = character; else overflow = true;
+
+                continue;
+
+            }
+
+            line[length] = 0;
+
+            CT_command_t command;
+
+            bool parsed = overflow == false && parseCommand(line, &command);
+
+            if (parsed == false) {
+
+                sendResponse(clientSocket, "ERROR Could not parse command.\n");
+
+            } else {
+
+                text[0] = 0;
+
+                bool handled = commandHandler(&command, text);
+
+                snprintf(response, STATUS_BUFFER_SIZE + CONTROL_RESPONSE_SIZE, "%s%s%s\n", handled ? "OK" : "ERROR", text[0] ? " " : "", text);
+
+                sendResponse(clientSocket, response);
+
+            }
+
+            length = 0;
+
+            overflow = false;
+
+        }
+
+    }
+
+    static void *controlThreadBody(void *ptr) {
+
+        while (true) {
+
+            int clientSocket = accept(serverSocket, NULL, NULL);
+
+            if (clientSocket < 0) continue;
+
+            #ifdef SO_NOSIGPIPE
+
+                int option = 1;
+
+                setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &option, sizeof(option));
+
+            #endif
+
+            serveClient(clientSocket);
+
+            close(clientSocket);
+
+        }
+
+        return NULL;
+
+    }
+
+    /* Public functions */
+
+    bool Control_initialise(const char *path, CT_handler_t handler) {
+
+        if (strlen(path) >= sizeof(address.sun_path)) return false;
+
+        commandHandler = handler;
+
+        memset(&address, 0, sizeof(struct sockaddr_un));
+
+        address.sun_family = AF_UNIX;
+
+        strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+        serverSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (serverSocket < 0) return false;
+
+        unlink(address.sun_path);
+
+        bool success = bind(serverSocket, (struct sockaddr*)&address, sizeof(struct sockaddr_un)) == 0;
+
+        success = success && listen(serverSocket, 1) == 0;
+
+        success = success && pthread_create(&controlThread, NULL, controlThreadBody, NULL) == 0;
+
+        if (success == false) {
+
+            close(serverSocket);
+
+            serverSocket = -1;
+
+        }
+
+        return success;
+
+    }
+
+    void Control_close(void) {
+
+        if (serverSocket < 0) return;
+
+        unlink(address.sun_path);
+
+    }
+
+#endif
@@ -0,0 +1,138 @@
+/****************************************************************************
+ * cpu.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+#if defined(_MSC_VER) && IS_X86
+    #include <intrin.h>
+#endif
+
+#if defined(__arm__) && defined(__linux__)
+    #include <sys/auxv.h>
+#endif
+
+/* CPUID register bits */
+
+#define CPUID_SSE2_BIT                  (1 << 26)
+#define CPUID_OSXSAVE_BIT               (1 << 27)
+#define CPUID_AVX2_BIT                  (1 << 5)
+#define CPUID_AVX512F_BIT               (1 << 16)
+
+/* Linux hardware capability bits for 32-bit ARM */
+
+#define HWCAP_NEON_BIT                  (1 << 12)
+
+/* XCR0 state bits */
+
+#define XCR0_AVX_STATE                  0x06
+#define XCR0_AVX512_STATE               0xE6
+
+/* Instruction set names */
+
+static char *instructionSetNames[] = {
+    [CPU_GENERIC] = "generic",
+    [CPU_SSE2] = "SSE2",
+    [CPU_AVX2] = "AVX2",
+    [CPU_AVX512] = "AVX-512",
+    [CPU_NEON] = "NEON"
+};
+
+/* Private function to query the processor */
+
+static CPU_instructionSet_t detectInstructionSet(void) {
+
+    #if defined(_MSC_VER) && IS_X86
+
+        /* Check the processor supports each extension and the operating system saves its registers */
+
+        int registers[4];
+
+        __cpuid(registers, 0);
+
+        int32_t maximumLeaf = registers[0];
+
+        __cpuid(registers, 1);
+
+        bool sse2 = (registers[3] & CPUID_SSE2_BIT) != 0;
+
+        bool osxsave = (registers[2] & CPUID_OSXSAVE_BIT) != 0;
+
+        uint64_t state = osxsave ? _xgetbv(0) : 0;
+
+        if (maximumLeaf >= 7) {
+
+            __cpuidex(registers, 7, 0);
+
+            if ((registers[1] & CPUID_AVX512F_BIT) && (state & XCR0_AVX512_STATE) == XCR0_AVX512_STATE) return CPU_AVX512;
+
+            if ((registers[1] & CPUID_AVX2_BIT) && (state & XCR0_AVX_STATE) == XCR0_AVX_STATE) return CPU_AVX2;
+
+        }
+
+        return sse2 ? CPU_SSE2 : CPU_GENERIC;
+
+    #elif IS_X86
+
+        /* The compiler builtins check operating system support as well */
+
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f")) return CPU_AVX512;
+
+        if (__builtin_cpu_supports("avx2")) return CPU_AVX2;
+
+        if (__builtin_cpu_supports("sse2")) return CPU_SSE2;
+
+        return CPU_GENERIC;
+
+    #elif defined(__aarch64__)
+
+        /* Advanced SIMD is part of the 64-bit ARM architecture */
+
+        return CPU_NEON;
+
+    #elif defined(__arm__) && defined(__linux__)
+
+        /* Ask the kernel as NEON is optional on 32-bit ARM and missing from the original Raspberry Pi and Pi Zero */
+
+        return (getauxval(AT_HWCAP) & HWCAP_NEON_BIT) ? CPU_NEON : CPU_GENERIC;
+
+    #else
+
+        return CPU_GENERIC;
+
+    #endif
+
+}
+
+/* Public functions */
+
+CPU_instructionSet_t CPU_getInstructionSet(void) {
+
+    static bool detected = false;
+
+    static CPU_instructionSet_t instructionSet = CPU_GENERIC;
+
+    if (detected == false) {
+
+        instructionSet = detectInstructionSet();
+
+        detected = true;
+
+    }
+
+    return instructionSet;
+
+}
+
+char *CPU_getInstructionSetName(CPU_instructionSet_t instructionSet) {
+
+    return instructionSetNames[instructionSet];
+
+}
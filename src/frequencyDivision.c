@@ -0,0 +1,118 @@
+/****************************************************************************
+ * frequencyDivision.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "macros.h"
+#include "biquad.h"
+#include "frequencyDivision.h"
+
+/* Envelope and output filter constants */
+
+#define ENVELOPE_FILTER_FREQUENCY       100
+#define ENVELOPE_FILTER_BANDWIDTH       1.0
+
+#define OUTPUT_FILTER_FREQUENCY         5000
+#define OUTPUT_FILTER_BANDWIDTH         1.0
+
+/* Zero crossing constants */
+
+#define HYSTERESIS_FRACTION             0.25
+#define MINIMUM_HYSTERESIS              16.0
+
+/* Global state variables */
+
+static BQ_filterCoefficients_t envelopeFilterCoefficients;
+
+static BQ_filterCoefficients_t outputFilterCoefficients;
+
+static BQ_filter_t envelopeFilter;
+
+static BQ_filter_t outputFilter;
+
+static int32_t divisor = 1;
+
+static int32_t crossingCounter;
+
+static bool inputPositive;
+
+static double outputSign = 1.0;
+
+/* Public functions */
+
+void FrequencyDivision_initialise(int32_t sampleRate, int32_t divisionRatio) {
+
+    Biquad_designLowPassFilter(&envelopeFilterCoefficients, sampleRate, ENVELOPE_FILTER_FREQUENCY, ENVELOPE_FILTER_BANDWIDTH);
+
+    Biquad_designLowPassFilter(&outputFilterCoefficients, sampleRate, OUTPUT_FILTER_FREQUENCY, OUTPUT_FILTER_BANDWIDTH);
+
+    Biquad_initialise(&envelopeFilter);
+
+    Biquad_initialise(&outputFilter);
+
+    divisor = divisionRatio;
+
+    crossingCounter = 0;
+
+    inputPositive = false;
+
+    outputSign = 1.0;
+
+}
+
+double FrequencyDivision_nextOutput(double sample) {
+
+    /* Follow the amplitude envelope of the input */
+
+    double envelope = Biquad_applyFilter(ABS(sample), &envelopeFilter, &envelopeFilterCoefficients);
+
+    /* Count zero crossings with hysteresis so that noise does not toggle the output */
+
+    double threshold = MAX(MINIMUM_HYSTERESIS, HYSTERESIS_FRACTION * envelope);
+
+    bool crossing = false;
+
+    if (inputPositive && sample < -threshold) {
+
+        inputPositive = false;
+
+        crossing = true;
+
+    } else if (inputPositive == false && sample > threshold) {
+
+        inputPositive = true;
+
+        crossing = true;
+
+    }
+
+    /* Toggle the output square wave every N crossings to divide the frequency by N */
+
+    if (crossing) {
+
+        crossingCounter += 1;
+
+        if (crossingCounter >= divisor) {
+
+            outputSign = -outputSign;
+
+            crossingCounter = 0;
+
+        }
+
+    }
+
+    /* Scale the square wave by the amplitude envelope */
+
+    double mixerOutput = outputSign * envelope;
+
+    double output = Biquad_applyFilter(mixerOutput, &outputFilter, &outputFilterCoefficients);
+
+    return output;
+
+}
@@ -22,6 +22,12 @@
 #define LOW_PASS_FILTER_FREQUENCY       5000
 #define LOW_PASS_FILTER_BANDWIDTH       1.0
 
+/* Fixed point constants with the oscillator in Q30 */
+
+#define OSCILLATOR_FRACTIONAL_BITS      30
+#define OSCILLATOR_ONE                  (1LL << OSCILLATOR_FRACTIONAL_BITS)
+#define OSCILLATOR_ROUNDING             (1LL << (OSCILLATOR_FRACTIONAL_BITS - 1))
+
 /* Global state variable */
 
 static BQ_filterCoefficients_t lowPassFilterCoefficients;
@@ -34,6 +40,18 @@ static double waveY = 0.0;
 static double dX;
 static double dY;
 
+/* Fixed point state variables */
+
+static BQ_fixedFilterCoefficients_t fixedLowPassFilterCoefficients;
+
+static BQ_fixedFilter_t fixedLowPassFilter;
+
+static int32_t fixedWaveX = OSCILLATOR_ONE;
+static int32_t fixedWaveY = 0;
+
+static int32_t fixedDX;
+static int32_t fixedDY;
+
 /* Public functions */
 
 void Heterodyne_initialise(int32_t sampleRate, int32_t frequency) {
@@ -43,6 +61,8 @@ void Heterodyne_initialise(int32_t sampleRate, int32_t frequency) {
     Biquad_designLowPassFilter(&lowPassFilterCoefficients, sampleRate, LOW_PASS_FILTER_FREQUENCY, LOW_PASS_FILTER_BANDWIDTH);
 
     Biquad_initialise(&lowPassFilter);
+
+    Biquad_initialiseFixed(&fixedLowPassFilter);
     
 }
 
@@ -55,6 +75,11 @@ void Heterodyne_updateFrequencies(int32_t sampleRate, int32_t frequency) {
     dX = cos(angle);
     dY = sin(angle);
 
+    Biquad_convertToFixedCoefficients(&fixedLowPassFilterCoefficients, &lowPassFilterCoefficients);
+
+    fixedDX = (int32_t)lround(dX * OSCILLATOR_ONE);
+    fixedDY = (int32_t)lround(dY * OSCILLATOR_ONE);
+
 }
 
 double Heterodyne_nextOutput(double sample) {
@@ -82,6 +107,29 @@ void Heterodyne_normalise(void) {
 
 }
 
+int32_t Heterodyne_nextFixedOutput(int32_t sample) {
+
+    int32_t newX = (int32_t)(((int64_t)fixedDX * fixedWaveX - (int64_t)fixedDY * fixedWaveY + OSCILLATOR_ROUNDING) >> OSCILLATOR_FRACTIONAL_BITS);
+    int32_t newY = (int32_t)(((int64_t)fixedDX * fixedWaveY + (int64_t)fixedDY * fixedWaveX + OSCILLATOR_ROUNDING) >> OSCILLATOR_FRACTIONAL_BITS);
 
+    fixedWaveX = newX;
+    fixedWaveY = newY;
 
+    int32_t mixerOutput = (int32_t)(((int64_t)sample * fixedWaveX + OSCILLATOR_ROUNDING) >> OSCILLATOR_FRACTIONAL_BITS);
 
+    int32_t output = Biquad_applyFixedFilter(mixerOutput, &fixedLowPassFilter, &fixedLowPassFilterCoefficients);
+
+    return output;
+
+}
+
+void Heterodyne_normaliseFixed(void) {
+
+    int64_t magnitude = ((int64_t)fixedWaveX * fixedWaveX + (int64_t)fixedWaveY * fixedWaveY + OSCILLATOR_ROUNDING) >> OSCILLATOR_FRACTIONAL_BITS;
+
+    int64_t correction = OSCILLATOR_ONE - (magnitude - OSCILLATOR_ONE) / 2;
+
+    fixedWaveX = (int32_t)((fixedWaveX * correction + OSCILLATOR_ROUNDING) >> OSCILLATOR_FRACTIONAL_BITS);
+    fixedWaveY = (int32_t)((fixedWaveY * correction + OSCILLATOR_ROUNDING) >> OSCILLATOR_FRACTIONAL_BITS);
+
+}
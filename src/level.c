@@ -0,0 +1,493 @@
+/****************************************************************************
+ * level.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+#include "level.h"
+#include "macros.h"
+#include "metrics.h"
+#include "xatomic.h"
+
+#if IS_X86
+    #include <immintrin.h>
+#endif
+
+#if IS_ARM
+    #include <arm_neon.h>
+#endif
+
+/* Level constants */
+
+#define INT16_SCALE                     32768.0
+
+#define FLOAT_CLIP_LEVEL                (32767.0f / 32768.0f)
+
+#define MINIMUM_DECIBELS                -120.0
+
+#define LEVEL_BLOCK_QUEUE_SIZE          8
+
+#define LEVEL_BLOCK_WORDS               (sizeof(LV_levels_t) / sizeof(int64_t))
+
+/* Vector widths in 16-bit samples */
+
+#define SSE2_WIDTH                      8
+#define AVX2_WIDTH                      16
+#define NEON_WIDTH                      8
+
+/* Integer totals gathered by the 16-bit kernels */
+
+typedef struct {
+    int32_t peak;
+    uint64_t sumOfSquares;
+    int64_t clippedSamples;
+} LV_integerLevels_t;
+
+/* Published block held as 64-bit words behind a sequence lock */
+
+typedef struct {
+    atomic_int_least64_t sequence;
+    atomic_int_least64_t words[LEVEL_BLOCK_WORDS];
+} LV_slot_t;
+
+/* Kernel selected for the processor */
+
+static void measureInt16Generic(const int16_t *samples, int32_t numberOfSamples, LV_integerLevels_t *integerLevels);
+
+static void (*measureInt16)(const int16_t *samples, int32_t numberOfSamples, LV_integerLevels_t *integerLevels) = measureInt16Generic;
+
+/* Capture block variables */
+
+static int32_t blockSize;
+
+static LV_levels_t currentBlock;
+
+/* Completed blocks are published to readers without a lock. A slot is only rewritten after the queue wraps and its sequence number lets a reader which is overtaken try again */
+
+static LV_slot_t blocks[LEVEL_BLOCK_QUEUE_SIZE];
+
+static atomic_int_least64_t blockCount;
+
+static atomic_int_least64_t clippedSampleCount;
+
+/* Functions to measure 16-bit samples */
+
+static void measureInt16Generic(const int16_t *samples, int32_t numberOfSamples, LV_integerLevels_t *integerLevels) {
+
+    for (int32_t i = 0; i < numberOfSamples; i += 1) {
+
+        int32_t sample = samples[i];
+
+        integerLevels->peak = MAX(integerLevels->peak, ABS(sample));
+
+        integerLevels->sumOfSquares += (uint64_t)(sample * sample);
+
+        if (sample == INT16_MAX || sample == INT16_MIN) integerLevels->clippedSamples += 1;
+
+    }
+
+}
+
+static void addLanes(LV_integerLevels_t *integerLevels, int16_t *maximums, int16_t *minimums, int32_t width, uint64_t *sums, int32_t numberOfSums, uint32_t *clips, int32_t numberOfClips) {
+
+    for (int32_t i = 0; i < width; i += 1) integerLevels->peak = MAX(integerLevels->peak, MAX(maximums[i], -minimums[i]));
+
+    for (int32_t i = 0; i < numberOfSums; i += 1) integerLevels->sumOfSquares += sums[i];
+
+    for (int32_t i = 0; i < numberOfClips; i += 1) integerLevels->clippedSamples += clips[i];
+
+}
+
+#if IS_X86
+
+    /* Squares are summed in pairs by madd and read as unsigned so that two full scale negative samples do not overflow. Clipped lanes are all ones so madd of the mask with itself counts them */
+
+    CPU_TARGET("sse2") static void measureInt16SSE2(const int16_t *samples, int32_t numberOfSamples, LV_integerLevels_t *integerLevels) {
+
+        int32_t i = 0;
+
+        __m128i zeros = _mm_setzero_si128();
+
+        __m128i upperLimits = _mm_set1_epi16(INT16_MAX);
+
+        __m128i lowerLimits = _mm_set1_epi16(INT16_MIN);
+
+        __m128i maximums = zeros, minimums = zeros, sums = zeros, clips = zeros;
+
+        for (; i + SSE2_WIDTH <= numberOfSamples; i += SSE2_WIDTH) {
+
+            __m128i values = _mm_loadu_si128((const __m128i*)(samples + i));
+
+            maximums = _mm_max_epi16(maximums, values);
+
+            minimums = _mm_min_epi16(minimums, values);
+
+            __m128i squares = _mm_madd_epi16(values, values);
+
+            sums = _mm_add_epi64(sums, _mm_add_epi64(_mm_unpacklo_epi32(squares, zeros), _mm_unpackhi_epi32(squares, zeros)));
+
+            __m128i clipped = _mm_or_si128(_mm_cmpeq_epi16(values, upperLimits), _mm_cmpeq_epi16(values, lowerLimits));
+
+            clips = _mm_add_epi32(clips, _mm_madd_epi16(clipped, clipped));
+
+        }
+
+        int16_t maximumLanes[SSE2_WIDTH], minimumLanes[SSE2_WIDTH];
+
+        uint64_t sumLanes[SSE2_WIDTH / 4];
+
+        uint32_t clipLanes[SSE2_WIDTH / 2];
+
+        _mm_storeu_si128((__m128i*)maximumLanes, maximums);
+
+        _mm_storeu_si128((__m128i*)minimumLanes, minimums);
+
+        _mm_storeu_si128((__m128i*)sumLanes, sums);
+
+        _mm_storeu_si128((__m128i*)clipLanes, clips);
+
+        addLanes(integerLevels, maximumLanes, minimumLanes, SSE2_WIDTH, sumLanes, SSE2_WIDTH / 4, clipLanes, SSE2_WIDTH / 2);
+
+        measureInt16Generic(samples + i, numberOfSamples - i, integerLevels);
+
+    }
+
+    CPU_TARGET("avx2") static void measureInt16AVX2(const int16_t *samples, int32_t numberOfSamples, LV_integerLevels_t *integerLevels) {
+
+        int32_t i = 0;
+
+        __m256i zeros = _mm256_setzero_si256();
+
+        __m256i upperLimits = _mm256_set1_epi16(INT16_MAX);
+
+        __m256i lowerLimits = _mm256_set1_epi16(INT16_MIN);
+
+        __m256i maximums = zeros, minimums = zeros, sums = zeros, clips = zeros;
+
+        for (; i + AVX2_WIDTH <= numberOfSamples; i += AVX2_WIDTH) {
+
+            __m256i values = _mm256_loadu_si256((const __m256i*)(samples + i));
+
+            maximums = _mm256_max_epi16(maximums, values);
+
+            minimums = _mm256_min_epi16(minimums, values);
+
+            __m256i squares = _mm256_madd_epi16(values, values);
+
+            sums = _mm256_add_epi64(sums, _mm256_add_epi64(_mm256_unpacklo_epi32(squares, zeros), _mm256_unpackhi_epi32(squares, zeros)));
+
+            __m256i clipped = _mm256_or_si256(_mm256_cmpeq_epi16(values, upperLimits), _mm256_cmpeq_epi16(values, lowerLimits));
+
+            clips = _mm256_add_epi32(clips, _mm256_madd_epi16(clipped, clipped));
+
+        }
+
+        int16_t maximumLanes[AVX2_WIDTH], minimumLanes[AVX2_WIDTH];
+
+        uint64_t sumLanes[AVX2_WIDTH / 4];
+
+        uint32_t clipLanes[AVX2_WIDTH / 2];
+
+        _mm256_storeu_si256((__m256i*)maximumLanes, maximums);
+
+        _mm256_storeu_si256((__m256i*)minimumLanes, minimums);
+
+        _mm256_storeu_si256((__m256i*)sumLanes, sums);
+
+        _mm256_storeu_si256((__m256i*)clipLanes, clips);
+
+        addLanes(integerLevels, maximumLanes, minimumLanes, AVX2_WIDTH, sumLanes, AVX2_WIDTH / 4, clipLanes, AVX2_WIDTH / 2);
+
+        measureInt16Generic(samples + i, numberOfSamples - i, integerLevels);
+
+    }
+
+#endif
+
+#if IS_ARM
+
+    CPU_NEON_TARGET static void measureInt16NEON(const int16_t *samples, int32_t numberOfSamples, LV_integerLevels_t *integerLevels) {
+
+        int32_t i = 0;
+
+        int16x8_t upperLimits = vdupq_n_s16(INT16_MAX);
+
+        int16x8_t lowerLimits = vdupq_n_s16(INT16_MIN);
+
+        int16x8_t maximums = vdupq_n_s16(0), minimums = vdupq_n_s16(0);
+
+        uint64x2_t sums = vdupq_n_u64(0);
+
+        uint32x4_t clips = vdupq_n_u32(0);
+
+        for (; i + NEON_WIDTH <= numberOfSamples; i += NEON_WIDTH) {
+
+            int16x8_t values = vld1q_s16(samples + i);
+
+            maximums = vmaxq_s16(maximums, values);
+
+            minimums = vminq_s16(minimums, values);
+
+            sums = vpadalq_u32(sums, vreinterpretq_u32_s32(vmull_s16(vget_low_s16(values), vget_low_s16(values))));
+
+            sums = vpadalq_u32(sums, vreinterpretq_u32_s32(vmull_s16(vget_high_s16(values), vget_high_s16(values))));
+
+            uint16x8_t clipped = vorrq_u16(vceqq_s16(values, upperLimits), vceqq_s16(values, lowerLimits));
+
+            clips = vpadalq_u16(clips, vshrq_n_u16(clipped, 15));
+
+        }
+
+        int16_t maximumLanes[NEON_WIDTH], minimumLanes[NEON_WIDTH];
+
+        uint64_t sumLanes[NEON_WIDTH / 4];
+
+        uint32_t clipLanes[NEON_WIDTH / 2];
+
+        vst1q_s16(maximumLanes, maximums);
+
+        vst1q_s16(minimumLanes, minimums);
+
+        vst1q_u64(sumLanes, sums);
+
+        vst1q_u32(clipLanes, clips);
+
+        addLanes(integerLevels, maximumLanes, minimumLanes, NEON_WIDTH, sumLanes, NEON_WIDTH / 4, clipLanes, NEON_WIDTH / 2);
+
+        measureInt16Generic(samples + i, numberOfSamples - i, integerLevels);
+
+    }
+
+#endif
+
+/* Function to measure float samples */
+
+static void measureFloat(LV_levels_t *levels, const float *samples, int32_t numberOfSamples) {
+
+    float peak = 0.0f;
+
+    double sumOfSquares = 0.0;
+
+    int64_t clippedSamples = 0;
+
+    for (int32_t i = 0; i < numberOfSamples; i += 1) {
+
+        float magnitude = fabsf(samples[i]);
+
+        peak = MAX(peak, magnitude);
+
+        sumOfSquares += (double)magnitude * magnitude;
+
+        if (magnitude >= FLOAT_CLIP_LEVEL) clippedSamples += 1;
+
+    }
+
+    levels->peak = MAX(levels->peak, peak);
+
+    levels->sumOfSquares += sumOfSquares;
+
+    levels->clippedSamples += clippedSamples;
+
+}
+
+/* Function to publish a completed capture block */
+
+static void publishBlock(void) {
+
+    int64_t words[LEVEL_BLOCK_WORDS];
+
+    memcpy(words, &currentBlock, sizeof(LV_levels_t));
+
+    int64_t count = atomic_load_explicit(&blockCount, memory_order_relaxed);
+
+    LV_slot_t *slot = blocks + count % LEVEL_BLOCK_QUEUE_SIZE;
+
+    /* The sequence number is odd while the slot is being written */
+
+    int64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+
+    atomic_thread_fence(memory_order_release);
+
+    for (size_t i = 0; i < LEVEL_BLOCK_WORDS; i += 1) atomic_store_explicit(slot->words + i, words[i], memory_order_relaxed);
+
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+
+    atomic_store_explicit(&blockCount, count + 1, memory_order_release);
+
+    atomic_fetch_add_explicit(&clippedSampleCount, currentBlock.clippedSamples, memory_order_relaxed);
+
+    Metrics_set(MT_PEAK_LEVEL, (int64_t)lround(Level_getPeakDecibels(&currentBlock) * METRICS_DECIBEL_SCALE));
+
+    Metrics_set(MT_RMS_LEVEL, (int64_t)lround(Level_getRMSDecibels(&currentBlock) * METRICS_DECIBEL_SCALE));
+
+    Metrics_add(MT_CLIPPED_SAMPLES, currentBlock.clippedSamples);
+
+    Level_reset(&currentBlock);
+
+}
+
+/* Public functions */
+
+void Level_setInstructionSet(CPU_instructionSet_t instructionSet) {
+
+    measureInt16 = measureInt16Generic;
+
+    #if IS_X86
+
+        /* AVX-512F has no 16-bit integer instructions so the AVX2 kernel is used instead */
+
+        if (instructionSet == CPU_SSE2) measureInt16 = measureInt16SSE2;
+
+        if (instructionSet == CPU_AVX2 || instructionSet == CPU_AVX512) measureInt16 = measureInt16AVX2;
+
+    #endif
+
+    #if IS_ARM
+
+        if (instructionSet == CPU_NEON) measureInt16 = measureInt16NEON;
+
+    #endif
+
+}
+
+void Level_reset(LV_levels_t *levels) {
+
+    levels->peak = 0.0;
+
+    levels->sumOfSquares = 0.0;
+
+    levels->numberOfSamples = 0;
+
+    levels->clippedSamples = 0;
+
+}
+
+void Level_combine(LV_levels_t *levels, LV_levels_t *otherLevels) {
+
+    levels->peak = MAX(levels->peak, otherLevels->peak);
+
+    levels->sumOfSquares += otherLevels->sumOfSquares;
+
+    levels->numberOfSamples += otherLevels->numberOfSamples;
+
+    levels->clippedSamples += otherLevels->clippedSamples;
+
+}
+
+void Level_measure(LV_levels_t *levels, const void *samples, int32_t numberOfSamples, bool floatSamples) {
+
+    if (numberOfSamples <= 0) return;
+
+    levels->numberOfSamples += numberOfSamples;
+
+    if (floatSamples) {
+
+        measureFloat(levels, (const float*)samples, numberOfSamples);
+
+        return;
+
+    }
+
+    LV_integerLevels_t integerLevels = {0, 0, 0};
+
+    measureInt16((const int16_t*)samples, numberOfSamples, &integerLevels);
+
+    levels->peak = MAX(levels->peak, integerLevels.peak / INT16_SCALE);
+
+    levels->sumOfSquares += integerLevels.sumOfSquares / (INT16_SCALE * INT16_SCALE);
+
+    levels->clippedSamples += integerLevels.clippedSamples;
+
+}
+
+double Level_getPeakDecibels(LV_levels_t *levels) {
+
+    if (levels->peak <= 0.0) return MINIMUM_DECIBELS;
+
+    return MAX(MINIMUM_DECIBELS, 20.0 * log10(levels->peak));
+
+}
+
+double Level_getRMSDecibels(LV_levels_t *levels) {
+
+    if (levels->numberOfSamples == 0 || levels->sumOfSquares <= 0.0) return MINIMUM_DECIBELS;
+
+    return MAX(MINIMUM_DECIBELS, 10.0 * log10(levels->sumOfSquares / levels->numberOfSamples));
+
+}
+
+void Level_setBlockSize(int32_t numberOfSamples) {
+
+    blockSize = numberOfSamples;
+
+    Level_reset(&currentBlock);
+
+}
+
+void Level_process(const void *samples, int32_t numberOfSamples, bool floatSamples) {
+
+    int32_t bytesPerSample = floatSamples ? sizeof(float) : sizeof(int16_t);
+
+    const char *position = (const char*)samples;
+
+    /* Split the samples at block boundaries */
+
+    while (numberOfSamples > 0 && blockSize > 0) {
+
+        int32_t count = (int32_t)MIN(numberOfSamples, blockSize - currentBlock.numberOfSamples);
+
+        Level_measure(&currentBlock, position, count, floatSamples);
+
+        if (currentBlock.numberOfSamples == blockSize) publishBlock();
+
+        position += (size_t)count * bytesPerSample;
+
+        numberOfSamples -= count;
+
+    }
+
+}
+
+bool Level_getLatestBlock(LV_levels_t *levels) {
+
+    int64_t words[LEVEL_BLOCK_WORDS];
+
+    int64_t before, after;
+
+    do {
+
+        int64_t count = atomic_load_explicit(&blockCount, memory_order_acquire);
+
+        if (count == 0) return false;
+
+        LV_slot_t *slot = blocks + (count - 1) % LEVEL_BLOCK_QUEUE_SIZE;
+
+        before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+
+        for (size_t i = 0; i < LEVEL_BLOCK_WORDS; i += 1) words[i] = atomic_load_explicit(slot->words + i, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+
+        after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+
+    } while (before != after || (before & 1));
+
+    memcpy(levels, words, sizeof(LV_levels_t));
+
+    return true;
+
+}
+
+int64_t Level_getClippedSamples(void) {
+
+    return atomic_load_explicit(&clippedSampleCount, memory_order_relaxed);
+
+}
@@ -0,0 +1,330 @@
+/****************************************************************************
+ * logger.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <time.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "queue.h"
+#include "xtime.h"
+#include "macros.h"
+#include "logger.h"
+#include "threads.h"
+#include "xatomic.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+/* Queue constants */
+
+#define LOGGER_QUEUE_SIZE               256
+#define LOGGER_MESSAGE_SIZE             256
+#define LOGGER_DRAIN_INTERVAL           10000
+
+/* Output constants */
+
+#define LOGGER_LINE_SIZE                (6 * LOGGER_MESSAGE_SIZE + 256)
+#define TIMESTAMP_BUFFER_SIZE           80
+
+#define MILLISECONDS_IN_SECOND          1000
+#define MICROSECONDS_IN_SECOND          1000000
+
+#define YEAR_OFFSET                     1900
+#define MONTH_OFFSET                    1
+
+/* Level and subsystem names */
+
+typedef struct {
+    char *tag;
+    char *name;
+} LG_description_t;
+
+static LG_description_t levels[] = {
+    [LG_INFO] = {"INFO", "info"},
+    [LG_WARNING] = {"WARNING", "warning"},
+    [LG_ERROR] = {"ERROR", "error"}
+};
+
+static LG_description_t subsystems[LG_NUMBER_OF_SUBSYSTEMS] = {
+    [LG_AUTOSAVE] = {"AUTOSAVE", "autosave"},
+    [LG_CAPTURE] = {"CAPTURE", "capture"},
+    [LG_PLAYBACK] = {"PLAYBACK", "playback"},
+    [LG_RECOVERY] = {"RECOVERY", "recovery"},
+    [LG_RETENTION] = {"RETENTION", "retention"},
+    [LG_STREAM] = {"STREAM", "stream"},
+    [LG_LOGGER] = {"LOGGER", "logger"}
+};
+
+/* Log entry captured by the calling thread */
+
+typedef struct {
+    LG_level_t level;
+    LG_subsystem_t subsystem;
+    int64_t monotonicTime;
+    int64_t utcTime;
+    char message[LOGGER_MESSAGE_SIZE];
+} LG_entry_t;
+
+/* Queue variables */
+
+static QU_queue_t *queue;
+
+static atomic_int_least64_t droppedEntries;
+
+/* Width of a status line redrawn with a carriage return, such as the level meter, which is blanked before each message so the two do not run together */
+
+static atomic_int statusWidth;
+
+/* Logger thread variables */
+
+static LG_format_t outputFormat;
+
+static atomic_bool running;
+
+static pthread_t loggerThread;
+
+/* Private functions */
+
+static void formatTimestamp(char *buffer, int64_t utcTime) {
+
+    struct tm time;
+
+    time_t rawTime = utcTime / MILLISECONDS_IN_SECOND;
+
+    Time_gmTime(&rawTime, &time);
+
+    snprintf(buffer, TIMESTAMP_BUFFER_SIZE, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", YEAR_OFFSET + time.tm_year, MONTH_OFFSET + time.tm_mon, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec, (int32_t)(utcTime % MILLISECONDS_IN_SECOND));
+
+}
+
+static char *escapeJSON(char *destination, const char *source) {
+
+    for (const char *character = source; *character != 0; character += 1) {
+
+        if (*character == '"' || *character == '\\') {
+
+            *destination++ = '\\';
+
+            *destination++ = *character;
+
+        } else if ((unsigned char)*character < ' ') {
+
+            destination += sprintf(destination, "\\u%04x", (unsigned char)*character);
+
+        } else {
+
+            *destination++ = *character;
+
+        }
+
+    }
+
+    *destination = 0;
+
+    return destination;
+
+}
+
+static void writeEntry(LG_entry_t *entry) {
+
+    static char line[LOGGER_LINE_SIZE];
+
+    static char timestamp[TIMESTAMP_BUFFER_SIZE];
+
+    formatTimestamp(timestamp, entry->utcTime);
+
+    if (outputFormat == LG_JSON) {
+
+        char *end = line + sprintf(line, "{\"time\":\"%s\",\"monotonic\":%lld.%06lld,\"level\":\"%s\",\"subsystem\":\"%s\",\"message\":\"", timestamp, (long long)(entry->monotonicTime / MICROSECONDS_IN_SECOND), (long long)(entry->monotonicTime % MICROSECONDS_IN_SECOND), levels[entry->level].name, subsystems[entry->subsystem].name);
+
+        end = escapeJSON(end, entry->message);
+
+        strcpy(end, "\"}\n");
+
+    } else {
+
+        int32_t width = atomic_load_explicit(&statusWidth, memory_order_relaxed);
+
+        if (width > 0) {
+
+            snprintf(line, LOGGER_LINE_SIZE, "\r%*s\r%s %s [%s] %s\n", width, "", timestamp, levels[entry->level].tag, subsystems[entry->subsystem].tag, entry->message);
+
+        } else {
+
+            snprintf(line, LOGGER_LINE_SIZE, "%s %s [%s] %s\n", timestamp, levels[entry->level].tag, subsystems[entry->subsystem].tag, entry->message);
+
+        }
+
+    }
+
+    fputs(line, stdout);
+
+}
+
+static int32_t drainEntries(void) {
+
+    int32_t numberOfEntries = 0;
+
+    LG_entry_t *queuedEntry;
+
+    while ((queuedEntry = (LG_entry_t*)Queue_peek(queue)) != NULL) {
+
+        writeEntry(queuedEntry);
+
+        Queue_release(queue);
+
+        numberOfEntries += 1;
+
+    }
+
+    /* Report entries which were dropped because the queue was full */
+
+    int64_t dropped = atomic_exchange_explicit(&droppedEntries, 0, memory_order_relaxed);
+
+    if (dropped > 0) {
+
+        static LG_entry_t entry;
+
+        entry.level = LG_WARNING;
+
+        entry.subsystem = LG_LOGGER;
+
+        entry.monotonicTime = Time_getMonotonicMicroseconds();
+
+        entry.utcTime = Time_getMillisecondUTC();
+
+        snprintf(entry.message, LOGGER_MESSAGE_SIZE, "Dropped %lld log messages", (long long)dropped);
+
+        writeEntry(&entry);
+
+    }
+
+    if (numberOfEntries > 0 || dropped > 0) fflush(stdout);
+
+    return numberOfEntries;
+
+}
+
+static void *loggerThreadBody(void *ptr) {
+
+    while (atomic_load(&running)) {
+
+        drainEntries();
+
+        usleep(LOGGER_DRAIN_INTERVAL);
+
+    }
+
+    drainEntries();
+
+    return NULL;
+
+}
+
+/* Public functions */
+
+bool Logger_initialise(LG_format_t format) {
+
+    outputFormat = format;
+
+    queue = Queue_create(LOGGER_QUEUE_SIZE, sizeof(LG_entry_t));
+
+    if (queue == NULL) return false;
+
+    atomic_init(&droppedEntries, 0);
+
+    atomic_store(&running, true);
+
+    if (pthread_create(&loggerThread, NULL, loggerThreadBody, NULL) != 0) {
+
+        atomic_store(&running, false);
+
+        return false;
+
+    }
+
+    return true;
+
+}
+
+void Logger_log(LG_level_t level, LG_subsystem_t subsystem, const char *format, ...) {
+
+    static LG_entry_t directEntry;
+
+    int64_t position;
+
+    LG_entry_t *slot = NULL;
+
+    /* Claim a slot without blocking, dropping the entry if the queue is full */
+
+    if (atomic_load_explicit(&running, memory_order_relaxed)) {
+
+        slot = (LG_entry_t*)Queue_claim(queue, &position);
+
+        if (slot == NULL) {
+
+            atomic_fetch_add_explicit(&droppedEntries, 1, memory_order_relaxed);
+
+            return;
+
+        }
+
+    }
+
+    /* Write directly before the logger thread has started or after it has stopped */
+
+    LG_entry_t *entry = slot == NULL ? &directEntry : slot;
+
+    entry->level = level;
+
+    entry->subsystem = subsystem;
+
+    entry->monotonicTime = Time_getMonotonicMicroseconds();
+
+    entry->utcTime = Time_getMillisecondUTC();
+
+    va_list arguments;
+
+    va_start(arguments, format);
+
+    vsnprintf(entry->message, LOGGER_MESSAGE_SIZE, format, arguments);
+
+    va_end(arguments);
+
+    if (slot == NULL) {
+
+        writeEntry(entry);
+
+        fflush(stdout);
+
+    } else {
+
+        Queue_publish(queue, position);
+
+    }
+
+}
+
+void Logger_setStatusWidth(int32_t width) {
+
+    atomic_store_explicit(&statusWidth, width, memory_order_relaxed);
+
+}
+
+void Logger_close(void) {
+
+    if (atomic_load(&running) == false) return;
+
+    atomic_store(&running, false);
+
+    pthread_join(loggerThread, NULL);
+
+}
@@ -14,19 +14,36 @@
 
 #define MINIAUDIO_IMPLEMENTATION
 
+#include "cpu.h"
 #include "xtime.h"
+#include "level.h"
 #include "macros.h"
 #include "threads.h"
+#include "stream.h"
+#include "capture.h"
+#include "control.h"
+#include "metrics.h"
+#include "network.h"
+#include "logger.h"
+#include "soundLevel.h"
+#include "retention.h"
+#include "sharedRing.h"
+#include "persistentRing.h"
 #include "wavFile.h"
 #include "xsignal.h"
+#include "xatomic.h"
 #include "autosave.h"
 #include "miniaudio.h"
 #include "heterodyne.h"
 #include "xdirectory.h"
+#include "frequencyDivision.h"
 
 /* Callback constants */
 
 #define CALLBACKS_PER_SECOND                10
+#define DEFAULT_CAPTURE_PERIOD_DURATION     (MILLISECONDS_IN_SECOND / CALLBACKS_PER_SECOND)
+#define MINIMUM_CAPTURE_PERIOD_DURATION     2
+#define MAXIMUM_CAPTURE_PERIOD_DURATION     1000
 
 /* Return state */
 
@@ -43,6 +60,8 @@
 
 #define AUDIO_BUFFER_SIZE                   (1 << 25)
 #define NUMBER_OF_BYTES_IN_SAMPLE           2
+#define MAXIMUM_NUMBER_OF_CHANNELS          8
+#define MINIMUM_BUFFER_DURATION             80
 
 /* Buffer constants */
 
@@ -51,6 +70,25 @@
 #define DEVICE_NAME_SIZE                    1024
 #define FILENAME_SIZE                       8192
 #define FILE_DESTINATION_SIZE               8192
+#define CONTROL_PATH_SIZE                   1024
+#define METRICS_PATH_SIZE                   1024
+#define STREAM_PATH_SIZE                    1024
+#define SOUND_LEVEL_PATH_SIZE               1024
+#define SHARED_MEMORY_NAME_SIZE             256
+#define PERSISTENT_RING_PATH_SIZE           1024
+#define NETWORK_ADDRESS_SIZE                64
+
+/* Recovery constants */
+
+#define RECOVERY_MARKER_NAME                ".AudioMoth-Live-current"
+#define RECOVERY_MARKER_FILENAME_SIZE       (FILE_DESTINATION_SIZE + sizeof(RECOVERY_MARKER_NAME) + 1)
+#define RECOVERED_DEVICE_NAME               "a persistent buffer recovered after an interrupted run"
+
+#if IS_WINDOWS
+    #define FILE_SEPARATOR                  "\\"
+#else
+    #define FILE_SEPARATOR                  "/"
+#endif
 
 /* Unit conversion constants */
 
@@ -75,14 +113,36 @@
 
 #define PLAYBACK_SAMPLE_RATE                48000
 
+/* Playback lag limits are measured in capture periods so monitor latency follows the period duration */
+
 #if IS_WINDOWS
-    #define MAXIMUM_PLAYBACK_LAG            (CALLBACKS_PER_SECOND / 2)
-    #define TARGET_PLAYBACK_LAG             (CALLBACKS_PER_SECOND / 10)
+    #define MAXIMUM_PLAYBACK_LAG            5
+    #define TARGET_PLAYBACK_LAG             1
+#else
+    #define MAXIMUM_PLAYBACK_LAG            2
+    #define TARGET_PLAYBACK_LAG             0
+#endif
+
+/* Fixed point constants with samples carrying extra fractional bits through the monitor filters */
+
+#if defined(FIXED_POINT_DSP)
+    #define FIXED_POINT_DEFAULT             true
 #else
-    #define MAXIMUM_PLAYBACK_LAG            (CALLBACKS_PER_SECOND / 4)
-    #define TARGET_PLAYBACK_LAG             (CALLBACKS_PER_SECOND / 20)
+    #define FIXED_POINT_DEFAULT             false
 #endif
 
+#define FIXED_SAMPLE_FRACTIONAL_BITS        8
+#define POSITION_FRACTIONAL_BITS            32
+#define WEIGHT_FRACTIONAL_BITS              16
+#define FIXED_POSITION_ONE                  (1LL << POSITION_FRACTIONAL_BITS)
+#define FIXED_SAMPLE_ONE                    (1 << FIXED_SAMPLE_FRACTIONAL_BITS)
+#define FIXED_WEIGHT_ONE                    (1LL << WEIGHT_FRACTIONAL_BITS)
+
+/* Capture device constants */
+
+#define MINIMUM_CAPTURE_PERIODS             2
+#define MAXIMUM_CAPTURE_PERIODS             16
+
 /* Autosave constants */
 
 #define AUTOSAVE_EVENT_QUEUE_SIZE           16
@@ -93,10 +153,55 @@
 
 #define MINIMUM_HETERODYNE_FREQUENCY        12000
 
+/* Network server constants */
+
+#define MINIMUM_NETWORK_PORT                1
+#define MAXIMUM_NETWORK_PORT                65535
+
+/* Retention constants */
+
+#define BYTES_IN_MEGABYTE                   (1024 * 1024)
+#define SECONDS_IN_HOUR                     (SECONDS_IN_MINUTE * MINUTES_IN_HOUR)
+
+/* Frequency division constants */
+
+#define MINIMUM_FREQUENCY_DIVISION_RATIO    2
+#define MAXIMUM_FREQUENCY_DIVISION_RATIO    32
+
+/* Time expansion constants */
+
+#define TIME_EXPANSION_FACTOR               10
+#define MINIMUM_TIME_EXPANSION_DURATION     10
+#define MAXIMUM_TIME_EXPANSION_DURATION     5000
+
+/* Float pipeline constant */
+
+#define INT16_SCALE                         32768.0
+
+/* Level meter constants */
+
+#define LEVEL_BLOCKS_PER_SECOND             10
+#define METER_LOG_INTERVAL                  MILLISECONDS_IN_SECOND
+#define METER_WIDTH                         30
+#define METER_FLOOR                         -60.0
+#define METER_LINE_SIZE                     128
+
+/* Monitor modes */
+
+typedef enum {MONITOR_NORMAL, MONITOR_HETERODYNE, MONITOR_FREQUENCY_DIVISION, MONITOR_TIME_EXPANSION} monitorMode_t;
+
 /* Audio buffer variables */
 
 static int16_t *audioBuffer;
 
+static float *floatAudioBuffer;
+
+static int16_t *channelAudioBuffer;
+
+static int32_t numberOfChannels = 1;
+
+static int32_t audioBufferFrames = AUDIO_BUFFER_SIZE;
+
 static int32_t audioBufferIndex;
 
 static int32_t audioBufferWriteIndex;
@@ -107,11 +212,29 @@ static pthread_mutex_t audioBufferMutex;
 
 static pthread_t startPlaybackThread;
 
+static bool playbackStarted;
+
+static pthread_mutex_t playbackMutex;
+
 /* Frontend state variables */
 
 static double timeDeviceStarted;
 
-static bool heterodyneEnabled;
+static bool monitorEnabled;
+
+static atomic_int monitorMode = MONITOR_NORMAL;
+
+static int32_t heterodyneFrequency;
+
+/* Monitor changes posted by other threads and applied by the playback callback, which owns the oscillator and filter state */
+
+static atomic_int heterodyneRequest;
+
+static atomic_bool frequencyDivisionRequest;
+
+static int32_t frequencyDivisionRatio;
+
+static int32_t timeExpansionDuration;
 
 static ma_timer timer;
 
@@ -119,6 +242,20 @@ static ma_timer timer;
 
 static char fileDestination[FILE_DESTINATION_SIZE];
 
+static WAV_directoryLayout_t directoryLayout = WAV_FLAT_LAYOUT;
+
+/* Retention variables */
+
+static bool retentionEnabled;
+
+static int32_t retentionMaximumSize;
+
+static int32_t retentionMaximumAge;
+
+static int32_t retentionMinimumFreeSpace;
+
+static char archiveDestination[FILE_DESTINATION_SIZE];
+
 /* Local time variable */
 
 static bool useLocalTime = true;
@@ -137,9 +274,69 @@ static bool backgroundDeviceCheckFoundAudioMoth;
 
 static bool backgroundDeviceCheckFoundOldAudioMoth;
 
+static bool backgroundRestartRequested;
+
+/* Control socket variable */
+
+static char controlPath[CONTROL_PATH_SIZE];
+
+/* Metrics export variable */
+
+static char metricsPath[METRICS_PATH_SIZE];
+
+/* Stream output variable */
+
+static char streamPath[STREAM_PATH_SIZE];
+
+/* Sound level log variable */
+
+static char soundLevelPath[SOUND_LEVEL_PATH_SIZE];
+
+/* Shared memory export variable */
+
+static char sharedMemoryName[SHARED_MEMORY_NAME_SIZE];
+
+/* Float pipeline variables */
+
+static bool floatPipelineEnabled;
+
+static WAV_sampleFormat_t wavFileFormat = WAV_INT16;
+
+/* Log output variable */
+
+static LG_format_t logFormat = LG_HUMAN;
+
+/* Capture device variables */
+
+static bool exclusiveModeEnabled;
+
+static int32_t capturePeriods;
+
+static int32_t capturePeriodDuration = DEFAULT_CAPTURE_PERIOD_DURATION;
+
+/* Arithmetic variable */
+
+static bool fixedPointEnabled = FIXED_POINT_DEFAULT;
+
+/* Level meter variable */
+
+static bool meterEnabled;
+
+/* Persistent ring buffer variable */
+
+static char persistentRingPath[PERSISTENT_RING_PATH_SIZE];
+
+/* Network server variables */
+
+static int32_t networkPort;
+
+static NT_protocol_t networkProtocol;
+
+static char networkBindAddress[NETWORK_ADDRESS_SIZE];
+
 /* Autosave capture variables */
 
-static int32_t autosaveDuration;
+static atomic_int autosaveDuration;
 
 static int64_t autosaveStartTime;
 
@@ -147,6 +344,8 @@ static int64_t autosaveSampleCount;
 
 static int64_t autosaveStartSampleCount;
 
+static int32_t autosaveStartSampleRate;
+
 /* Autosave file variables */
 
 static time_t autosaveFileStartTime;
@@ -157,6 +356,18 @@ static int64_t autosaveFileStartCount;
 
 static int32_t autosaveFileSampleRate;
 
+static char autosaveFilename[FILENAME_SIZE];
+
+static int64_t autosaveFileLength;
+
+static bool autosaveFileNeedsRelease;
+
+static bool autosaveDirectWriterEnabled;
+
+static bool autosavePreallocationEnabled;
+
+static WAV_durability_t autosaveDurability = WAV_SYNC_NONE;
+
 /* Autosave state variables */
 
 static bool autosaveShutdownCompleted;
@@ -255,935 +466,2436 @@ void capture_notification_callback(const ma_device_notification *pNotification)
 
 }
 
-void playback_data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount) {
-
-    int16_t *outputBuffer = (int16_t*)pOutput;
-
-    /* Static playback variables */
-
-    static double playbackPosition = 0;
+static inline int16_t getMonitorSample(int32_t index) {
 
-    static int32_t playbackReadIndex = 0;
+    if (audioBuffer != NULL) return audioBuffer[index];
 
-    static double playbackNextSample = 0;
+    return Capture_convertFloatSample(floatAudioBuffer[(size_t)index * numberOfChannels]);
 
-    static double playbackCurrentSample = 0;
+}
 
-    static bool playbackBufferWaiting = false;
+static inline double applyMonitorMode(double sample, monitorMode_t mode) {
 
-    /* Calculate the buffer lag */
+    if (mode == MONITOR_HETERODYNE) return Heterodyne_nextOutput(sample);
 
-    int32_t sampleLag = (AUDIO_BUFFER_SIZE + audioBufferWriteIndex - playbackReadIndex) % AUDIO_BUFFER_SIZE;
+    if (mode == MONITOR_FREQUENCY_DIVISION) return FrequencyDivision_nextOutput(sample);
 
-    int32_t bufferLag = sampleLag * CALLBACKS_PER_SECOND / currentSampleRate;
+    return sample;
 
-    /* Check minimum buffer lag */
+}
 
-    if (bufferLag > MAXIMUM_PLAYBACK_LAG) {
-       
-        playbackReadIndex = audioBufferWriteIndex;
+static void fillTimeExpansionBuffer(int16_t *outputBuffer, ma_uint32 frameCount) {
 
-        playbackBufferWaiting = true;
+    /* Static time expansion variables */
 
-        sampleLag = 0;
+    static double expansionPosition = 0;
 
-        bufferLag = 0;
+    static int32_t expansionReadIndex = 0;
 
-    }
+    static int32_t expansionRemainingSamples = 0;
 
-    /* Update shared global variables */
+    static double expansionNextSample = 0;
 
-    bool starvation = sampleLag < (int32_t)frameCount;
+    static double expansionCurrentSample = 0;
 
-    /* Provide samples to playback device */
+    /* Replay the ring at a fraction of the capture rate */
 
-    if (playbackBufferWaiting || starvation) {
+    int32_t sampleRateDivider = MAXIMUM_SAMPLE_RATE / PLAYBACK_SAMPLE_RATE;
 
-        for (ma_uint32 i = 0; i < frameCount; i += 1) outputBuffer[i] = 0;
+    double step = (double)currentSampleRate / (double)MAXIMUM_SAMPLE_RATE / (double)TIME_EXPANSION_FACTOR;
 
-    } else {
+    for (ma_uint32 i = 0; i < frameCount; i += 1) {
 
-        if (heterodyneEnabled) Heterodyne_normalise();
+        double playbackAccumulator = 0;
 
-        int32_t sampleRateDivider = MAXIMUM_SAMPLE_RATE / PLAYBACK_SAMPLE_RATE;
+        for (int32_t j = 0; j < sampleRateDivider; j += 1) {
 
-        double step = (double)currentSampleRate / (double)MAXIMUM_SAMPLE_RATE;
+            playbackAccumulator += expansionCurrentSample + expansionPosition * (expansionNextSample - expansionCurrentSample);
 
-        for (ma_uint32 i = 0; i < frameCount; i += 1) {
+            expansionPosition += step;
 
-            double playbackAccumulator = 0;
+            if (expansionPosition >= 1.0) {
 
-            for (int32_t j = 0; j < sampleRateDivider; j += 1) {
+                /* Jump to the most recent segment once the previous one has been replayed */
 
-                double sample = playbackCurrentSample + playbackPosition * (playbackNextSample - playbackCurrentSample);
+                if (expansionRemainingSamples == 0) {
 
-                playbackAccumulator += heterodyneEnabled ? Heterodyne_nextOutput(sample) : sample;
+                    expansionRemainingSamples = (int32_t)((int64_t)timeExpansionDuration * currentSampleRate / MILLISECONDS_IN_SECOND);
 
-                playbackPosition += step;
+                    expansionReadIndex = (audioBufferFrames + audioBufferWriteIndex - expansionRemainingSamples) % audioBufferFrames;
 
-                if (playbackPosition >= 1.0) {
+                }
 
-                    playbackCurrentSample = playbackNextSample;
+                expansionCurrentSample = expansionNextSample;
 
-                    playbackNextSample = audioBuffer[playbackReadIndex];
+                expansionNextSample = getMonitorSample(expansionReadIndex);
 
-                    playbackReadIndex = (playbackReadIndex + 1) % AUDIO_BUFFER_SIZE;
+                expansionReadIndex = (expansionReadIndex + 1) % audioBufferFrames;
 
-                    playbackPosition -= 1.0;
+                expansionRemainingSamples -= 1;
 
-                }
+                expansionPosition -= 1.0;
 
             }
 
-            double sample = MAX(INT16_MIN, MIN(INT16_MAX, round(playbackAccumulator / (double)sampleRateDivider)));
+        }
 
-            outputBuffer[i] = (int16_t)sample;
+        double sample = MAX(INT16_MIN, MIN(INT16_MAX, round(playbackAccumulator / (double)sampleRateDivider)));
 
-        }
+        outputBuffer[i] = (int16_t)sample;
 
     }
 
-    if (bufferLag > TARGET_PLAYBACK_LAG) playbackBufferWaiting = false;
-
 }
 
-void capture_data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount) {
+/* Playback variables */
 
-    int64_t startTime = 0;
+static double playbackPosition;
 
-    int32_t increment = 0;
+static int32_t playbackReadIndex;
 
-    int16_t *inputBuffer = (int16_t*)pInput;
+static double playbackNextSample;
 
-    int32_t sampleRateDivider = (int32_t)ceil(inputDeviceSampleRate / currentSampleRate);
+static double playbackCurrentSample;
 
-    int32_t interpolationSampleRate = sampleRateDivider * currentSampleRate;
+static int64_t playbackFixedPosition;
 
-    double step = (double)inputDeviceSampleRate / (double)interpolationSampleRate;
+static int32_t playbackFixedNextSample;
 
-    /* Static resample variables */
+static int32_t playbackFixedCurrentSample;
 
-    static int32_t resampleCounter = 0;
+/* Function to divide with rounding half away from zero to match round() */
 
-    static double resamplePosition = 0;
+static inline int64_t roundedQuotient(int64_t numerator, int64_t denominator) {
 
-    static double resampleNextSample = 0;
+    return numerator >= 0 ? (numerator + denominator / 2) / denominator : -((denominator / 2 - numerator) / denominator);
 
-    static double resampleAccumulator = 0;
+}
 
-    static double resampleCurrentSample = 0;
+/* Playback kernels with the monitor mode as a compile-time constant so the inner loop does not branch on it */
 
-    /* Check for restart */
+typedef void (*playbackKernel_t)(int16_t *outputBuffer, ma_uint32 frameCount);
 
-    pthread_mutex_lock(&stopStartMutex);
+static inline void fillPlaybackBuffer(int16_t *outputBuffer, ma_uint32 frameCount, monitorMode_t mode) {
 
-    bool restart = started == false;
+    int32_t sampleRateDivider = MAXIMUM_SAMPLE_RATE / PLAYBACK_SAMPLE_RATE;
 
-    pthread_mutex_unlock(&stopStartMutex);
+    double step = (double)currentSampleRate / (double)MAXIMUM_SAMPLE_RATE;
 
-    if (restart) {
+    for (ma_uint32 i = 0; i < frameCount; i += 1) {
 
-        /* Get start time */
+        double playbackAccumulator = 0;
 
-        startTime = Time_getMillisecondUTC();
+        for (int32_t j = 0; j < sampleRateDivider; j += 1) {
 
-        /* Reset resampler */
+            double sample = playbackCurrentSample + playbackPosition * (playbackNextSample - playbackCurrentSample);
 
-        resampleCounter = 0;
+            playbackAccumulator += applyMonitorMode(sample, mode);
 
-        resamplePosition = 0;
+            playbackPosition += step;
 
-        resampleNextSample = 0;
+            if (playbackPosition >= 1.0) {
 
-        resampleAccumulator = 0;
+                playbackCurrentSample = playbackNextSample;
 
-        resampleCurrentSample = 0;
+                playbackNextSample = getMonitorSample(playbackReadIndex);
 
-    }
+                playbackReadIndex = (playbackReadIndex + 1) % audioBufferFrames;
 
-    /* Process samples */
+                playbackPosition -= 1.0;
 
-    for (ma_uint32 i = 0; i < frameCount; i += 1) {
+            }
 
-        resampleCurrentSample = resampleNextSample;
+        }
 
-        resampleNextSample = inputBuffer[i];
+        double sample = MAX(INT16_MIN, MIN(INT16_MAX, round(playbackAccumulator / (double)sampleRateDivider)));
 
-        while (resamplePosition < 1.0) {
+        outputBuffer[i] = (int16_t)sample;
 
-            resampleAccumulator += resampleCurrentSample + resamplePosition * (resampleNextSample - resampleCurrentSample);
+    }
 
-            resampleCounter += 1;
+}
 
-            if (resampleCounter == sampleRateDivider) {
+static inline void fillPlaybackBufferFixed(int16_t *outputBuffer, ma_uint32 frameCount, monitorMode_t mode) {
 
-                double sample = MAX(INT16_MIN, MIN(INT16_MAX, round(resampleAccumulator / (double)sampleRateDivider)));
+    int32_t sampleRateDivider = MAXIMUM_SAMPLE_RATE / PLAYBACK_SAMPLE_RATE;
 
-                audioBuffer[audioBufferIndex] = (int16_t)sample;
+    int64_t step = ((int64_t)currentSampleRate << POSITION_FRACTIONAL_BITS) / MAXIMUM_SAMPLE_RATE;
 
-                audioBufferIndex = (audioBufferIndex + 1) % AUDIO_BUFFER_SIZE;
+    for (ma_uint32 i = 0; i < frameCount; i += 1) {
 
-                resampleAccumulator = 0;
+        int64_t playbackAccumulator = 0;
 
-                resampleCounter = 0;
+        for (int32_t j = 0; j < sampleRateDivider; j += 1) {
 
-                increment += 1;
+            int32_t weight = (int32_t)(playbackFixedPosition >> (POSITION_FRACTIONAL_BITS - WEIGHT_FRACTIONAL_BITS));
 
-            }
+            int32_t sample = playbackFixedCurrentSample * FIXED_SAMPLE_ONE + (int32_t)(((int64_t)weight * (playbackFixedNextSample - playbackFixedCurrentSample)) >> (WEIGHT_FRACTIONAL_BITS - FIXED_SAMPLE_FRACTIONAL_BITS));
 
-            resamplePosition += step;
+            playbackAccumulator += mode == MONITOR_HETERODYNE ? Heterodyne_nextFixedOutput(sample) : sample;
 
-        }
+            playbackFixedPosition += step;
 
-        resamplePosition -= 1.0;
-    
-    }   
+            if (playbackFixedPosition >= FIXED_POSITION_ONE) {
 
-    pthread_mutex_lock(&audioBufferMutex);
+                playbackFixedCurrentSample = playbackFixedNextSample;
 
-    audioBufferWriteIndex = (audioBufferWriteIndex + increment) % AUDIO_BUFFER_SIZE;
+                playbackFixedNextSample = getMonitorSample(playbackReadIndex);
 
-    if (restart) {
-        
-        autosaveStartTime = startTime;
+                playbackReadIndex = (playbackReadIndex + 1) % audioBufferFrames;
 
-        autosaveStartSampleCount = autosaveSampleCount;
+                playbackFixedPosition -= FIXED_POSITION_ONE;
 
-    }
+            }
 
-    autosaveSampleCount += increment;
+        }
 
-    pthread_mutex_unlock(&audioBufferMutex);
+        int64_t sample = roundedQuotient(playbackAccumulator, (int64_t)sampleRateDivider << FIXED_SAMPLE_FRACTIONAL_BITS);
 
-    if (restart) {
+        outputBuffer[i] = (int16_t)MAX(INT16_MIN, MIN(INT16_MAX, sample));
 
-        pthread_mutex_lock(&stopStartMutex);
+    }
 
-        started = true;
+}
 
-        pthread_mutex_unlock(&stopStartMutex);
+static void fillNormalPlaybackBuffer(int16_t *outputBuffer, ma_uint32 frameCount) {
 
-    }
+    fillPlaybackBuffer(outputBuffer, frameCount, MONITOR_NORMAL);
 
 }
 
-/* Functions to check for AudioMoth */
+static void fillHeterodynePlaybackBuffer(int16_t *outputBuffer, ma_uint32 frameCount) {
 
-ma_bool32 enumerate_devices_callback(ma_context *pContext, ma_device_type deviceType, const ma_device_info* deviceInfo, void *pUserData) {
+    fillPlaybackBuffer(outputBuffer, frameCount, MONITOR_HETERODYNE);
 
-    enumerate_devices_t *enumerateDevices = (enumerate_devices_t*)pUserData;
+}
 
-    if (strstr(deviceInfo->name, "F32x USBXpress Device")) enumerateDevices->device_check.oldAudioMothFound = true;
+static void fillFrequencyDivisionPlaybackBuffer(int16_t *outputBuffer, ma_uint32 frameCount) {
 
-    if (strstr(deviceInfo->name, "AudioMoth")) {
+    fillPlaybackBuffer(outputBuffer, frameCount, MONITOR_FREQUENCY_DIVISION);
 
-        if (strstr(deviceInfo->name, "kHz AudioMoth") == NULL) enumerateDevices->device_check.oldAudioMothFound = true;
+}
 
-        enumerateDevices->device_check.audioMothFound = true;
+static void fillNormalPlaybackBufferFixed(int16_t *outputBuffer, ma_uint32 frameCount) {
 
-        if (enumerateDevices->updateAudioMothSettings) { 
+    fillPlaybackBufferFixed(outputBuffer, frameCount, MONITOR_NORMAL);
 
-            memcpy(&audioMothDeviceID, &(deviceInfo->id), sizeof(ma_device_id));
+}
 
-            char *digit = strstr(deviceInfo->name, "kHz") - 1;
+static void fillHeterodynePlaybackBufferFixed(int16_t *outputBuffer, ma_uint32 frameCount) {
 
-            if (digit == NULL) {
+    fillPlaybackBufferFixed(outputBuffer, frameCount, MONITOR_HETERODYNE);
 
-                audioMothSampleRate = MAXIMUM_SAMPLE_RATE;
+}
 
-            } else {
+static playbackKernel_t playbackKernels[] = {
+    [MONITOR_NORMAL] = fillNormalPlaybackBuffer,
+    [MONITOR_HETERODYNE] = fillHeterodynePlaybackBuffer,
+    [MONITOR_FREQUENCY_DIVISION] = fillFrequencyDivisionPlaybackBuffer
+};
 
-                int32_t multiplier = 1000;
+/* Frequency division has no fixed point implementation so uses the floating point kernel */
 
-                audioMothSampleRate = 0;
+static playbackKernel_t fixedPlaybackKernels[] = {
+    [MONITOR_NORMAL] = fillNormalPlaybackBufferFixed,
+    [MONITOR_HETERODYNE] = fillHeterodynePlaybackBufferFixed,
+    [MONITOR_FREQUENCY_DIVISION] = fillFrequencyDivisionPlaybackBuffer
+};
 
-                do {
+void playback_data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount) {
 
-                    audioMothSampleRate += multiplier * (*digit - '0');
+    int16_t *outputBuffer = (int16_t*)pOutput;
 
-                    multiplier *= 10;
+    /* Apply monitor changes before generating any output */
 
-                    digit -= 1;
+    int32_t requestedFrequency = atomic_exchange_explicit(&heterodyneRequest, 0, memory_order_acquire);
 
-                } while (*digit >= '0' && *digit <= '9');
+    if (requestedFrequency > 0) Heterodyne_updateFrequencies(currentSampleRate, requestedFrequency);
 
-            }
+    if (atomic_exchange_explicit(&frequencyDivisionRequest, false, memory_order_acquire)) FrequencyDivision_initialise(currentSampleRate, frequencyDivisionRatio);
 
-        }
+    /* Time expansion replays earlier audio so does not track the buffer lag */
 
-        return MA_FALSE;
+    if (monitorMode == MONITOR_TIME_EXPANSION) {
 
-    }
+        fillTimeExpansionBuffer(outputBuffer, frameCount);
 
-    return MA_TRUE;
+        return;
 
-}
+    }
 
-static device_check_t checkForAudioMoth(ma_context *context, bool updateAudioMothSettings) {
+    /* Static playback variable */
 
-    enumerate_devices_t info = {
-        .updateAudioMothSettings = updateAudioMothSettings,
-        .device_check.oldAudioMothFound = false,
-        .device_check.audioMothFound = false
-    };
+    static bool playbackBufferWaiting = false;
 
-    ma_result result = ma_context_enumerate_devices(context, enumerate_devices_callback, (void*)&info);
+    /* Calculate the buffer lag */
 
-    if (result != MA_SUCCESS) {
+    int32_t sampleLag = (audioBufferFrames + audioBufferWriteIndex - playbackReadIndex) % audioBufferFrames;
 
-        device_check_t device_check = {
-            .oldAudioMothFound = false,
-            .audioMothFound = false
-        };
+    int32_t bufferLag = (int32_t)((int64_t)sampleLag * MILLISECONDS_IN_SECOND / ((int64_t)currentSampleRate * capturePeriodDuration));
 
-        return device_check;
+    /* Check minimum buffer lag */
 
-    }
+    if (bufferLag > MAXIMUM_PLAYBACK_LAG) {
+       
+        playbackReadIndex = audioBufferWriteIndex;
 
-    return info.device_check;
-    
-}
+        playbackBufferWaiting = true;
 
-/* Thread functions to start and stop capture device */
+        sampleLag = 0;
 
-static bool startMicrophone(ma_context *context, bool usingAudioMoth) {
+        bufferLag = 0;
 
-    /* Initialise capture device */
+    }
 
-    ma_device_config captureDeviceConfig = ma_device_config_init(ma_device_type_capture);
+    /* Update shared global variables */
 
-    captureDeviceConfig.capture.pDeviceID = usingAudioMoth ? &audioMothDeviceID : NULL;
-    captureDeviceConfig.capture.format = ma_format_s16;
-    captureDeviceConfig.capture.channels = 1;
-    captureDeviceConfig.capture.shareMode  = ma_share_mode_shared;
+    bool starvation = sampleLag < (int32_t)frameCount;
 
-    inputDeviceSampleRate = usingAudioMoth ? audioMothSampleRate : maximumDefaultSampleRate;
+    if (starvation && playbackBufferWaiting == false) Metrics_add(MT_PLAYBACK_STARVATIONS, 1);
 
-    sprintf(inputDeviceName, usingAudioMoth ? "%dkHz AudioMoth USB Microphone" : "%dkHz Default Input", inputDeviceSampleRate / HERTZ_IN_KILOHERTZ);
+    /* Provide samples to playback device */
 
-    sprintf(inputDeviceCommentName, usingAudioMoth ? "a %dkHz AudioMoth USB Microphone" : "the %dkHz default input", inputDeviceSampleRate / HERTZ_IN_KILOHERTZ);
+    if (playbackBufferWaiting || starvation) {
 
-    currentSampleRate = MIN(requestedSampleRate, inputDeviceSampleRate);
+        for (ma_uint32 i = 0; i < frameCount; i += 1) outputBuffer[i] = 0;
 
-    captureDeviceConfig.sampleRate = inputDeviceSampleRate;
-    captureDeviceConfig.periodSizeInFrames = inputDeviceSampleRate / CALLBACKS_PER_SECOND;
-    captureDeviceConfig.dataCallback = capture_data_callback;
-    captureDeviceConfig.notificationCallback = capture_notification_callback;
+    } else {
 
-    ma_result result = ma_device_init(context, &captureDeviceConfig, &captureDevice);
+        if (monitorMode == MONITOR_HETERODYNE && fixedPointEnabled) Heterodyne_normaliseFixed();
 
-    if (result != MA_SUCCESS) return false;
+        if (monitorMode == MONITOR_HETERODYNE && fixedPointEnabled == false) Heterodyne_normalise();
 
-    /* Start the capture device */
+        playbackKernel_t *kernels = fixedPointEnabled ? fixedPlaybackKernels : playbackKernels;
 
-    result = ma_device_start(&captureDevice);
+        kernels[monitorMode](outputBuffer, frameCount);
 
-    if (result != MA_SUCCESS) return false;
+    }
 
-    return true;
+    if (bufferLag > TARGET_PLAYBACK_LAG) playbackBufferWaiting = false;
 
 }
 
-void stopMicrophone(void) {
+/* Capture resampler variables with one entry per channel */
 
-    ma_device_stop(&captureDevice);
+static int32_t resampleCounter;
 
-    ma_device_uninit(&captureDevice);
-        
-    memset(&captureDevice, 0, sizeof(ma_device));
+static double resamplePosition;
 
-}
+static double resampleNextSample[MAXIMUM_NUMBER_OF_CHANNELS];
 
-/* Static thread functions to start and stop playback device */
+static double resampleAccumulator[MAXIMUM_NUMBER_OF_CHANNELS];
 
-static void *startPlaybackThreadBody(void *ptr) {
+static double resampleCurrentSample[MAXIMUM_NUMBER_OF_CHANNELS];
 
-    /* Initialise playback device */
+static int64_t resampleFixedPosition;
 
-    ma_device_config playbackDeviceConfig = ma_device_config_init(ma_device_type_playback);
+static int32_t resampleFixedNextSample[MAXIMUM_NUMBER_OF_CHANNELS];
 
-    playbackDeviceConfig.playback.pDeviceID = NULL;
-    playbackDeviceConfig.playback.format = ma_format_s16;
-    playbackDeviceConfig.playback.channels = 1;
+static int64_t resampleFixedAccumulator[MAXIMUM_NUMBER_OF_CHANNELS];
 
-    playbackDeviceConfig.sampleRate = PLAYBACK_SAMPLE_RATE;
-    playbackDeviceConfig.periodSizeInFrames = PLAYBACK_SAMPLE_RATE / CALLBACKS_PER_SECOND;
-    playbackDeviceConfig.dataCallback = playback_data_callback;
-    playbackDeviceConfig.notificationCallback = NULL;
+static int32_t resampleFixedCurrentSample[MAXIMUM_NUMBER_OF_CHANNELS];
 
-    ma_result result = ma_device_init(&playbackContext, &playbackDeviceConfig, &playbackDevice);
+/* Capture kernel variables set by startMicrophone */
 
-    if (result != MA_SUCCESS) {
-        
-        puts("[ERROR] Failed to initialise playback device");
+typedef int32_t (*captureKernel_t)(const void *input, int32_t frameCount);
 
-        return NULL;
+static captureKernel_t captureKernel;
 
-    }
+static int32_t captureSampleRateDivider;
 
-    /* Start the playback device */
+static double captureStep;
 
-    result = ma_device_start(&playbackDevice);
+static int64_t captureFixedStep;
 
-    if (result != MA_SUCCESS) puts("[ERROR] Failed to start playback device");
+/* Capture functions which write frames to the ring buffers and return the number of frames written */
 
-    return NULL;
+static inline void storeResampledFrame(double scale, bool floatInput) {
 
-}
+    /* The mono buffer, when there is one, holds the first channel for monitoring and streaming while the interleaved buffers hold every channel */
 
-/* Background and autosave functions */
+    if (audioBuffer != NULL) audioBuffer[audioBufferIndex] = (int16_t)MAX(INT16_MIN, MIN(INT16_MAX, round(resampleAccumulator[0] * scale)));
 
-static void addAutosaveEvent(AS_event_type_t eventType) {
+    int32_t frameIndex = audioBufferIndex * numberOfChannels;
 
-    AS_event_t event;
+    if (floatInput) {
 
-    event.type = eventType;
+        for (int32_t channel = 0; channel < numberOfChannels; channel += 1) {
 
-    event.sampleRate = currentSampleRate;
+            floatAudioBuffer[frameIndex + channel] = (float)(resampleAccumulator[channel] * scale / INT16_SCALE);
 
-    pthread_mutex_lock(&audioBufferMutex);
+        }
 
-    event.currentCount = autosaveSampleCount;
-    event.currentIndex = audioBufferWriteIndex;
- 
-    event.startTime = autosaveStartTime;
-    event.startCount = autosaveStartSampleCount;
+    } else if (channelAudioBuffer != NULL) {
 
-    pthread_mutex_unlock(&audioBufferMutex);
+        for (int32_t channel = 0; channel < numberOfChannels; channel += 1) {
 
-    memcpy(event.inputDeviceCommentName, inputDeviceCommentName, DEVICE_NAME_SIZE);
+            channelAudioBuffer[frameIndex + channel] = (int16_t)MAX(INT16_MIN, MIN(INT16_MAX, round(resampleAccumulator[channel] * scale)));
 
-    Autosave_addEvent(&event);
+        }
 
-}
+    }
 
-/* Private function */
+    audioBufferIndex = (audioBufferIndex + 1) % audioBufferFrames;
 
-static void formatFileTime(char *buffer, time_t start, time_t stop, int32_t timeOffset) {
+    memset(resampleAccumulator, 0, sizeof(resampleAccumulator));
 
-    struct tm time;
+    resampleCounter = 0;
 
-    time_t rawTime = start + timeOffset;
+}
 
-    Time_gmTime(&rawTime, &time);
+static inline double getInputSample(const void *input, int32_t index, bool floatInput) {
 
-    buffer += sprintf(buffer, "%02d:%02d:%02d to ", time.tm_hour, time.tm_min, time.tm_sec);
+    return floatInput ? ((float*)input)[index] * INT16_SCALE : ((int16_t*)input)[index];
 
-    rawTime = stop + timeOffset;
+}
 
-    Time_gmTime(&rawTime, &time);
+static void copyToRing(void *ring, const void *frames, int32_t numberOfFrames, int32_t bytesPerFrame) {
 
-    buffer += sprintf(buffer, "%02d:%02d:%02d (UTC", time.tm_hour, time.tm_min, time.tm_sec);
+    /* Split the copy where it wraps around the end of the ring */
 
-    int32_t timeOffsetMinutes = timeOffset / SECONDS_IN_MINUTE;
+    int32_t numberOfFrames1 = MIN(numberOfFrames, audioBufferFrames - audioBufferIndex);
 
-    int32_t timezoneHours = timeOffsetMinutes / MINUTES_IN_HOUR;
+    int32_t numberOfFrames2 = numberOfFrames - numberOfFrames1;
 
-    int32_t timezoneMinutes = timeOffsetMinutes % MINUTES_IN_HOUR;
+    memcpy((char*)ring + (size_t)bytesPerFrame * audioBufferIndex, frames, (size_t)bytesPerFrame * numberOfFrames1);
 
-    if (timezoneHours < 0) {
+    memcpy(ring, (char*)frames + (size_t)bytesPerFrame * numberOfFrames1, (size_t)bytesPerFrame * numberOfFrames2);
 
-        buffer += sprintf(buffer, "%d", timezoneHours);
+}
 
-    } else if (timezoneHours > 0) {
+static int32_t passthroughFrames(const void *input, int32_t frameCount) {
 
-        buffer += sprintf(buffer, "+%d", timezoneHours);
+    int16_t *inputBuffer = (int16_t*)input;
 
-    } else {
+    float *floatInputBuffer = (float*)input;
 
-        if (timezoneMinutes < 0) buffer += sprintf(buffer, "-0");
+    if (floatPipelineEnabled) {
 
-        if (timezoneMinutes > 0) buffer += sprintf(buffer, "+0");
+        copyToRing(floatAudioBuffer, input, frameCount, sizeof(float) * numberOfChannels);
 
-    }
+    } else if (channelAudioBuffer != NULL) {
 
-    if (timezoneMinutes < 0) buffer += sprintf(buffer, ":%02d", -timezoneMinutes);
+        copyToRing(channelAudioBuffer, input, frameCount, NUMBER_OF_BYTES_IN_SAMPLE * numberOfChannels);
 
-    if (timezoneMinutes > 0) buffer += sprintf(buffer, ":%02d", timezoneMinutes);
+    } else {
 
-    sprintf(buffer, ")");
+        copyToRing(audioBuffer, input, frameCount, NUMBER_OF_BYTES_IN_SAMPLE);
 
-}
+        audioBufferIndex = (audioBufferIndex + frameCount) % audioBufferFrames;
 
-static bool writeAutosaveFile(int32_t duration) {
+        return frameCount;
 
-    bool success = false;
+    }
 
-    static WAV_header_t autosaveHeader;
+    /* Copy the first channel to the mono buffer unless it is derived from the float buffer on read */
 
-    static int32_t previousLocalTimeOffset = 0;
+    if (audioBuffer == NULL) {
 
-    static char autosaveFilename[FILENAME_SIZE];
+        audioBufferIndex = (audioBufferIndex + frameCount) % audioBufferFrames;
 
-    static time_t autosaveFilePreviousStopTime = 0;
+        return frameCount;
 
-    if (duration == 0) return true;
+    }
 
-    /* Read local time offset */
+    for (int32_t i = 0; i < frameCount; i += 1) {
 
-    int32_t localTimeOffset = useLocalTime ? Time_getLocalTimeOffset() : 0;
+        audioBuffer[audioBufferIndex] = floatPipelineEnabled ? Capture_convertFloatSample(floatInputBuffer[i * numberOfChannels]) : inputBuffer[i * numberOfChannels];
 
-    /* Determine whether file should be appended */
+        audioBufferIndex = (audioBufferIndex + 1) % audioBufferFrames;
 
-    struct tm timeStart;
+    }
 
-    time_t rawTimeStart = autosaveFileStartTime;
+    return frameCount;
 
-    Time_gmTime(&rawTimeStart, &timeStart);
-    
-    bool append = localTimeOffset == previousLocalTimeOffset;
-    
-    append &= autosaveFileStartTime == autosaveFilePreviousStopTime;
+}
 
-    append &= timeStart.tm_sec == 0 && timeStart.tm_min % autosaveDuration > 0;
+static inline int32_t decimateFrames(const void *input, int32_t frameCount, int32_t ratio, bool floatInput) {
 
-    autosaveFilePreviousStopTime = autosaveFileStartTime + duration;
+    int32_t increment = 0;
 
-    previousLocalTimeOffset = localTimeOffset;
+    double scale = 1.0 / (double)ratio;
 
-    /* Write the output WAV file */
+    /* An integer ratio needs no interpolation so each output frame is the mean of the input frames it covers */
 
-    int32_t numberOfSamples = duration * autosaveFileSampleRate;
+    for (int32_t i = 0; i < frameCount; i += 1) {
 
-    int32_t overlap = autosaveFileStartIndex + numberOfSamples - AUDIO_BUFFER_SIZE;
+        for (int32_t channel = 0; channel < numberOfChannels; channel += 1) {
 
-    if (append == true) {
+            resampleAccumulator[channel] += getInputSample(input, i * numberOfChannels + channel, floatInput);
 
-        if (overlap < 0) {
+        }
 
-            success = WavFile_appendFile(autosaveFilename, audioBuffer + autosaveFileStartIndex, numberOfSamples, NULL, 0);
+        resampleCounter += 1;
 
-        } else {
+        if (resampleCounter == ratio) {
 
-            success = WavFile_appendFile(autosaveFilename, audioBuffer + autosaveFileStartIndex, numberOfSamples - overlap, audioBuffer, overlap);
+            storeResampledFrame(scale, floatInput);
+
+            increment += 1;
 
         }
 
     }
 
-    if (append == false || success == false) {
-
-        WavFile_initialiseHeader(&autosaveHeader);
-
-        WavFile_setHeaderDetails(&autosaveHeader, autosaveFileSampleRate, numberOfSamples);
+    return increment;
 
-        WavFile_setHeaderComment(&autosaveHeader, (int32_t)autosaveFileStartTime + localTimeOffset, -1, localTimeOffset, autosaveInputDeviceCommentName);
+}
 
-        WavFile_setFilename(autosaveFilename, (int32_t)autosaveFileStartTime + localTimeOffset, -1, fileDestination);
+static inline int32_t resampleFrames(const void *input, int32_t frameCount, bool floatInput) {
 
-        if (overlap < 0) {
+    int32_t increment = 0;
 
-            success = WavFile_writeFile(&autosaveHeader, autosaveFilename, audioBuffer + autosaveFileStartIndex, numberOfSamples, NULL, 0);
+    int32_t sampleRateDivider = captureSampleRateDivider;
 
-        } else {
+    double step = captureStep;
 
-            success = WavFile_writeFile(&autosaveHeader, autosaveFilename, audioBuffer + autosaveFileStartIndex, numberOfSamples - overlap, audioBuffer, overlap);
+    double scale = 1.0 / (double)sampleRateDivider;
 
-        }
+    /* Process frames with each step applied to all channels together so the inner loops vectorise */
 
-    }
+    for (int32_t i = 0; i < frameCount; i += 1) {
 
-    /* Log output file */
+        for (int32_t channel = 0; channel < numberOfChannels; channel += 1) {
 
-    static char buffer[FILE_TIME_BUFFER_SIZE];
+            resampleCurrentSample[channel] = resampleNextSample[channel];
 
-    formatFileTime(buffer, autosaveFileStartTime, autosaveFilePreviousStopTime, localTimeOffset);
+            resampleNextSample[channel] = getInputSample(input, i * numberOfChannels + channel, floatInput);
 
-    puts(buffer);
+        }
 
-    /* Return status */
+        while (resamplePosition < 1.0) {
 
-    return success;
+            for (int32_t channel = 0; channel < numberOfChannels; channel += 1) {
 
-}
+                resampleAccumulator[channel] += resampleCurrentSample[channel] + resamplePosition * (resampleNextSample[channel] - resampleCurrentSample[channel]);
 
-static bool makeMinuteTransitionRecording(void) {
+            }
 
-    /* Generate partial recording */
+            resampleCounter += 1;
 
-    int64_t sampleCountDifference = autosaveTargetCount - autosaveFileStartCount;
+            if (resampleCounter == sampleRateDivider) {
 
-    int32_t duration = (int32_t)(sampleCountDifference / autosaveFileSampleRate);
+                storeResampledFrame(scale, floatInput);
 
-    bool success = writeAutosaveFile(duration);
+                increment += 1;
 
-    /* Update for next minute transition */
+            }
 
-    autosaveFileStartTime += duration;
+            resamplePosition += step;
 
-    autosaveFileStartIndex = (autosaveFileStartIndex + sampleCountDifference) % AUDIO_BUFFER_SIZE;
+        }
 
-    autosaveFileStartCount = autosaveTargetCount;
+        resamplePosition -= 1.0;
 
-    autosaveTargetCount = autosaveFileStartCount + SECONDS_IN_MINUTE * autosaveFileSampleRate;
+    }
 
-    return success;
+    return increment;
 
 }
 
-static void updateForMillisecondOffset(int32_t milliseconds) {
-
-    /* Update count, index and time for millisecond offset */
+/* Fixed point capture functions for 16-bit input which avoid floating point arithmetic altogether */
 
-    if (milliseconds > 0) {
-        
-        int32_t millisecondOffset = MILLISECONDS_IN_SECOND - milliseconds;
+static inline void storeFixedFrame(int64_t divisor) {
 
-        int32_t sampleOffset = ROUNDED_DIV(autosaveFileSampleRate * millisecondOffset, MILLISECONDS_IN_SECOND);
+    int32_t frameIndex = audioBufferIndex * numberOfChannels;
 
-        autosaveFileStartCount += sampleOffset;
+    audioBuffer[audioBufferIndex] = (int16_t)MAX(INT16_MIN, MIN(INT16_MAX, roundedQuotient(resampleFixedAccumulator[0], divisor)));
 
-        autosaveFileStartIndex = (autosaveFileStartIndex + sampleOffset) % AUDIO_BUFFER_SIZE;
+    if (channelAudioBuffer != NULL) {
 
-        autosaveFileStartTime += 1;
+        for (int32_t channel = 0; channel < numberOfChannels; channel += 1) {
 
-    }
+            channelAudioBuffer[frameIndex + channel] = (int16_t)MAX(INT16_MIN, MIN(INT16_MAX, roundedQuotient(resampleFixedAccumulator[channel], divisor)));
 
-    /* Calculate target sample count for the next minute transition */
+        }
 
-    struct tm time;
+    }
 
-    time_t rawTime = autosaveFileStartTime;
+    audioBufferIndex = (audioBufferIndex + 1) % audioBufferFrames;
 
-    Time_gmTime(&rawTime, &time);
+    memset(resampleFixedAccumulator, 0, sizeof(resampleFixedAccumulator));
 
-    autosaveTargetCount = autosaveFileStartCount + (SECONDS_IN_MINUTE - time.tm_sec) * autosaveFileSampleRate;
+    resampleCounter = 0;
 
 }
 
-static void *backgroundThreadBody(void *ptr) {
+static inline int32_t decimateFramesFixed(const void *input, int32_t frameCount, int32_t ratio) {
 
-    static AS_event_t event;
-    
-    while (true) {
+    int32_t increment = 0;
 
-        /* Check for AudioMoth */
+    int16_t *inputBuffer = (int16_t*)input;
 
-        pthread_mutex_lock(&backgroundDeviceCheckMutex);
+    /* Integer sums are exact so rounding the quotient matches the floating point decimator */
 
-        device_check_t device_check = checkForAudioMoth(&deviceCheckContext, false);
+    for (int32_t i = 0; i < frameCount; i += 1) {
 
-        bool audioMothFound = device_check.audioMothFound;
-        
-        bool oldAudioMothFound = device_check.oldAudioMothFound;
+        for (int32_t channel = 0; channel < numberOfChannels; channel += 1) {
 
-        pthread_mutex_unlock(&backgroundDeviceCheckMutex);
+            resampleFixedAccumulator[channel] += inputBuffer[i * numberOfChannels + channel];
 
-        pthread_mutex_lock(&backgroundMutex);
+        }
 
-        backgroundDeviceCheckTime = ma_timer_get_time_in_seconds(&timer);
+        resampleCounter += 1;
 
-        backgroundDeviceCheckFoundAudioMoth = audioMothFound;
+        if (resampleCounter == ratio) {
 
-        backgroundDeviceCheckFoundOldAudioMoth = oldAudioMothFound;
+            storeFixedFrame(ratio);
 
-        pthread_mutex_unlock(&backgroundMutex);
+            increment += 1;
 
-        /* Get current sample count and autosave duration */
+        }
 
-        pthread_mutex_lock(&audioBufferMutex);
+    }
 
-        int64_t currentSampleCount = autosaveSampleCount;
+    return increment;
 
-        pthread_mutex_unlock(&audioBufferMutex);
+}
 
-        /* Process autosave events */
+static int32_t resampleFramesFixed(const void *input, int32_t frameCount) {
 
-        bool success = true;
+    int32_t increment = 0;
 
-        while (Autosave_hasEvents()) {
+    int16_t *inputBuffer = (int16_t*)input;
 
-            /* Copy and remove first event */
+    int32_t sampleRateDivider = captureSampleRateDivider;
 
-            Autosave_getFirstEvent(&event);
+    int64_t divisor = (int64_t)sampleRateDivider << WEIGHT_FRACTIONAL_BITS;
 
-            /* Process event */
+    /* The position is held in Q32 so the rate does not drift and the interpolation weight in Q16 */
 
-            if (autosaveWaitingForStartEvent && event.type == AS_START) {
+    for (int32_t i = 0; i < frameCount; i += 1) {
 
-                /* Set sample rate and device */
+        for (int32_t channel = 0; channel < numberOfChannels; channel += 1) {
 
-                autosaveFileSampleRate = event.sampleRate;
+            resampleFixedCurrentSample[channel] = resampleFixedNextSample[channel];
 
-                memcpy(autosaveInputDeviceCommentName, event.inputDeviceCommentName, DEVICE_NAME_SIZE);
+            resampleFixedNextSample[channel] = inputBuffer[i * numberOfChannels + channel];
 
-                /* Adjust start time to match current count and index */
+        }
 
-                int64_t countDifference = event.currentCount - event.startCount;
+        while (resampleFixedPosition < FIXED_POSITION_ONE) {
 
-                int64_t updatedStartTime = event.startTime + ROUNDED_DIV(countDifference * MILLISECONDS_IN_SECOND, autosaveFileSampleRate);
+            int64_t weight = resampleFixedPosition >> (POSITION_FRACTIONAL_BITS - WEIGHT_FRACTIONAL_BITS);
 
-                int32_t milliseconds = updatedStartTime % MILLISECONDS_IN_SECOND;
+            for (int32_t channel = 0; channel < numberOfChannels; channel += 1) {
 
-                autosaveFileStartTime = updatedStartTime / MILLISECONDS_IN_SECOND;
+                resampleFixedAccumulator[channel] += resampleFixedCurrentSample[channel] * FIXED_WEIGHT_ONE + weight * (resampleFixedNextSample[channel] - resampleFixedCurrentSample[channel]);
 
-                autosaveFileStartCount = event.currentCount;
+            }
 
-                autosaveFileStartIndex = event.currentIndex;
+            resampleCounter += 1;
 
-                /* Update start time, count and index for millisecond offset */
+            if (resampleCounter == sampleRateDivider) {
 
-                updateForMillisecondOffset(milliseconds); 
+                storeFixedFrame(divisor);
 
-                /* Reset flag */
-                
-                autosaveWaitingForStartEvent = false;
+                increment += 1;
 
             }
 
-            if (currentSampleCount >= autosaveTargetCount && autosaveTargetCount < event.currentCount) {
+            resampleFixedPosition += captureFixedStep;
 
-                success &= makeMinuteTransitionRecording();
+        }
 
-            }
+        resampleFixedPosition -= FIXED_POSITION_ONE;
 
-            if (event.type == AS_RESTART) {
+    }
 
-                /* Write samples since last start to file */
+    return increment;
 
-                int32_t duration = (int32_t)(event.startCount - autosaveFileStartCount) / autosaveFileSampleRate;
+}
 
-                success &= writeAutosaveFile(duration);
+/* Capture kernels with the input format and decimation ratio as compile-time constants */
 
-                /* Set sample rate and device */
+#define CAPTURE_KERNELS(name, call) \
+    static int32_t name##Int16(const void *input, int32_t frameCount) { return call(input, frameCount, false); } \
+    static int32_t name##Float(const void *input, int32_t frameCount) { return call(input, frameCount, true); }
 
-                autosaveFileSampleRate = event.sampleRate;
+#define DECIMATION_KERNELS(ratio) \
+    static inline int32_t decimateBy##ratio(const void *input, int32_t frameCount, bool floatInput) { return decimateFrames(input, frameCount, ratio, floatInput); } \
+    static int32_t decimateBy##ratio##Fixed(const void *input, int32_t frameCount) { return decimateFramesFixed(input, frameCount, ratio); } \
+    CAPTURE_KERNELS(decimateBy##ratio, decimateBy##ratio)
 
-                memcpy(autosaveInputDeviceCommentName, event.inputDeviceCommentName, DEVICE_NAME_SIZE);
+#define DECIMATION_KERNEL_ENTRY(ratio)      {ratio, decimateBy##ratio##Int16, decimateBy##ratio##Float, decimateBy##ratio##Fixed}
 
-                /* Adjust current index to match start time and count */
+static inline int32_t decimateByDivider(const void *input, int32_t frameCount, bool floatInput) {
 
-                int32_t milliseconds = event.startTime % MILLISECONDS_IN_SECOND;
+    return decimateFrames(input, frameCount, captureSampleRateDivider, floatInput);
 
-                autosaveFileStartTime = event.startTime / MILLISECONDS_IN_SECOND;
+}
 
-                autosaveFileStartCount = event.startCount;
+static int32_t decimateByDividerFixed(const void *input, int32_t frameCount) {
 
-                int64_t countDifference = (event.currentCount - event.startCount);
+    return decimateFramesFixed(input, frameCount, captureSampleRateDivider);
 
-                autosaveFileStartIndex = (AUDIO_BUFFER_SIZE + event.currentIndex - countDifference) % AUDIO_BUFFER_SIZE;
+}
 
-                /* Update start time, count and index for millisecond offset */
+CAPTURE_KERNELS(resample, resampleFrames)
 
-                updateForMillisecondOffset(milliseconds);
+CAPTURE_KERNELS(decimateByDivider, decimateByDivider)
 
-            }
+/* Every integer ratio between the AudioMoth and default input rates and the valid sample rates */
 
-            if (event.type == AS_STOP) {
+DECIMATION_KERNELS(2)
+DECIMATION_KERNELS(3)
+DECIMATION_KERNELS(4)
+DECIMATION_KERNELS(6)
+DECIMATION_KERNELS(8)
+DECIMATION_KERNELS(12)
+DECIMATION_KERNELS(24)
+DECIMATION_KERNELS(48)
 
-                /* Write samples since last start to file */
+typedef struct {
+    int32_t ratio;
+    captureKernel_t int16Kernel;
+    captureKernel_t floatKernel;
+    captureKernel_t fixedKernel;
+} captureKernelEntry_t;
 
-                int32_t duration = (int32_t)(event.currentCount - autosaveFileStartCount) / autosaveFileSampleRate;
+static captureKernelEntry_t decimationKernels[] = {
+    DECIMATION_KERNEL_ENTRY(2),
+    DECIMATION_KERNEL_ENTRY(3),
+    DECIMATION_KERNEL_ENTRY(4),
+    DECIMATION_KERNEL_ENTRY(6),
+    DECIMATION_KERNEL_ENTRY(8),
+    DECIMATION_KERNEL_ENTRY(12),
+    DECIMATION_KERNEL_ENTRY(24),
+    DECIMATION_KERNEL_ENTRY(48)
+};
 
-                success &= writeAutosaveFile(duration);
+static void selectCaptureKernel(void) {
 
-                /* Reset flags */
+    captureSampleRateDivider = inputDeviceSampleRate / currentSampleRate;
 
-                autosaveWaitingForStartEvent = true;
+    captureStep = (double)inputDeviceSampleRate / (double)(captureSampleRateDivider * currentSampleRate);
 
-                autosaveTargetCount = INT64_MAX;
+    captureFixedStep = ((int64_t)inputDeviceSampleRate << POSITION_FRACTIONAL_BITS) / ((int64_t)captureSampleRateDivider * currentSampleRate);
 
-            }
+    /* Fixed point arithmetic only applies to 16-bit capture */
 
-            if (event.type == AS_SHUTDOWN) {
+    bool fixedPointKernel = fixedPointEnabled && floatPipelineEnabled == false;
 
-                if (autosaveWaitingForStartEvent == false) {
+    /* Copy at the native rate, use a specialised decimator for an integer ratio and interpolate otherwise */
 
-                    /* Write samples since last start to file */
+    if (inputDeviceSampleRate == currentSampleRate) {
 
-                    int32_t duration = (int32_t)(event.currentCount - autosaveFileStartCount) / autosaveFileSampleRate;
+        captureKernel = passthroughFrames;
 
-                    writeAutosaveFile(duration);
+        return;
 
-                }
+    }
 
-                pthread_mutex_lock(&autosaveMutex);
+    if (inputDeviceSampleRate % currentSampleRate == 0) {
 
-                autosaveShutdownCompleted = true;
+        captureKernel = fixedPointKernel ? decimateByDividerFixed : floatPipelineEnabled ? decimateByDividerFloat : decimateByDividerInt16;
 
-                pthread_mutex_unlock(&autosaveMutex);
+        for (size_t i = 0; i < sizeof(decimationKernels) / sizeof(captureKernelEntry_t); i += 1) {
 
-                /* Reset flags */
+            if (decimationKernels[i].ratio == captureSampleRateDivider) captureKernel = fixedPointKernel ? decimationKernels[i].fixedKernel : floatPipelineEnabled ? decimationKernels[i].floatKernel : decimationKernels[i].int16Kernel;
 
-                autosaveWaitingForStartEvent = true;
+        }
 
-                autosaveTargetCount = INT64_MAX;
+        return;
 
-            }
+    }
 
-        }
+    captureKernel = fixedPointKernel ? resampleFramesFixed : floatPipelineEnabled ? resampleFloat : resampleInt16;
 
-        if (currentSampleCount >= autosaveTargetCount) {
+}
+
+void capture_data_callback(ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount) {
 
-            success &= makeMinuteTransitionRecording();
+    int64_t startTime = 0;
 
-        }
+    int32_t increment = 0;
 
-        /* Thread safe callback */
+    /* Check for restart */
 
-        if (success == false) {
+    pthread_mutex_lock(&stopStartMutex);
 
-            puts("[AUTOSAVE] Could not write WAV file");
+    bool restart = started == false;
 
-        }
+    pthread_mutex_unlock(&stopStartMutex);
 
-        /* Calculate delay period to wait for next update */
+    if (restart) {
 
-        uint32_t microseconds = Time_getMicroseconds();
+        /* Get start time */
+
+        startTime = Time_getMillisecondUTC();
+
+        /* Reset resampler */
+
+        resampleCounter = 0;
+
+        resamplePosition = 0;
+
+        memset(resampleNextSample, 0, sizeof(resampleNextSample));
+
+        memset(resampleAccumulator, 0, sizeof(resampleAccumulator));
+
+        memset(resampleCurrentSample, 0, sizeof(resampleCurrentSample));
+
+        resampleFixedPosition = 0;
+
+        memset(resampleFixedNextSample, 0, sizeof(resampleFixedNextSample));
+
+        memset(resampleFixedAccumulator, 0, sizeof(resampleFixedAccumulator));
+
+        memset(resampleFixedCurrentSample, 0, sizeof(resampleFixedCurrentSample));
+
+    }
+
+    /* Measure the input levels */
+
+    Level_process(pInput, frameCount * numberOfChannels, floatPipelineEnabled);
+
+    /* Process frames with the kernel selected when the device started */
+
+    increment = captureKernel(pInput, frameCount);
+
+    pthread_mutex_lock(&audioBufferMutex);
+
+    audioBufferWriteIndex = (audioBufferWriteIndex + increment) % audioBufferFrames;
+
+    if (restart) {
+        
+        autosaveStartTime = startTime;
+
+        autosaveStartSampleCount = autosaveSampleCount;
+
+        autosaveStartSampleRate = currentSampleRate;
+
+    }
+
+    autosaveSampleCount += increment;
+
+    SharedRing_publish(autosaveStartSampleRate, audioBufferWriteIndex, autosaveSampleCount, autosaveStartTime, autosaveStartSampleCount);
+
+    PersistentRing_publish(autosaveStartSampleRate, autosaveSampleCount, autosaveStartTime, autosaveStartSampleCount);
+
+    pthread_mutex_unlock(&audioBufferMutex);
+
+    Metrics_add(MT_SAMPLES_CAPTURED, increment);
+
+    if (restart) {
+
+        pthread_mutex_lock(&stopStartMutex);
+
+        started = true;
+
+        pthread_mutex_unlock(&stopStartMutex);
+
+    }
+
+}
+
+/* Function to share the capture state with output sinks */
+
+void Capture_getState(CP_state_t *state) {
+
+    state->buffer = audioBuffer;
+
+    state->floatBuffer = floatAudioBuffer;
+
+    state->numberOfChannels = numberOfChannels;
+
+    state->bufferSize = audioBufferFrames;
+
+    pthread_mutex_lock(&audioBufferMutex);
+
+    state->sampleRate = autosaveStartSampleRate;
+
+    state->writeIndex = audioBufferWriteIndex;
+
+    state->sampleCount = autosaveSampleCount;
+
+    state->startTime = autosaveStartTime;
+
+    state->startCount = autosaveStartSampleCount;
+
+    pthread_mutex_unlock(&audioBufferMutex);
+
+}
+
+/* Functions to check for AudioMoth */
+
+ma_bool32 enumerate_devices_callback(ma_context *pContext, ma_device_type deviceType, const ma_device_info* deviceInfo, void *pUserData) {
+
+    enumerate_devices_t *enumerateDevices = (enumerate_devices_t*)pUserData;
+
+    if (strstr(deviceInfo->name, "F32x USBXpress Device")) enumerateDevices->device_check.oldAudioMothFound = true;
+
+    if (strstr(deviceInfo->name, "AudioMoth")) {
+
+        if (strstr(deviceInfo->name, "kHz AudioMoth") == NULL) enumerateDevices->device_check.oldAudioMothFound = true;
+
+        enumerateDevices->device_check.audioMothFound = true;
+
+        if (enumerateDevices->updateAudioMothSettings) { 
+
+            memcpy(&audioMothDeviceID, &(deviceInfo->id), sizeof(ma_device_id));
+
+            char *digit = strstr(deviceInfo->name, "kHz") - 1;
+
+            if (digit == NULL) {
+
+                audioMothSampleRate = MAXIMUM_SAMPLE_RATE;
+
+            } else {
+
+                int32_t multiplier = 1000;
+
+                audioMothSampleRate = 0;
+
+                do {
+
+                    audioMothSampleRate += multiplier * (*digit - '0');
+
+                    multiplier *= 10;
+
+                    digit -= 1;
+
+                } while (*digit >= '0' && *digit <= '9');
+
+            }
+
+        }
+
+        return MA_FALSE;
+
+    }
+
+    return MA_TRUE;
+
+}
+
+static device_check_t checkForAudioMoth(ma_context *context, bool updateAudioMothSettings) {
+
+    enumerate_devices_t info = {
+        .updateAudioMothSettings = updateAudioMothSettings,
+        .device_check.oldAudioMothFound = false,
+        .device_check.audioMothFound = false
+    };
+
+    ma_result result = ma_context_enumerate_devices(context, enumerate_devices_callback, (void*)&info);
+
+    if (result != MA_SUCCESS) {
+
+        device_check_t device_check = {
+            .oldAudioMothFound = false,
+            .audioMothFound = false
+        };
+
+        return device_check;
+
+    }
+
+    return info.device_check;
+    
+}
+
+/* Thread functions to start and stop capture device */
+
+static bool startMicrophone(ma_context *context, bool usingAudioMoth) {
+
+    /* Initialise capture device */
+
+    ma_device_config captureDeviceConfig = ma_device_config_init(ma_device_type_capture);
+
+    captureDeviceConfig.capture.pDeviceID = usingAudioMoth ? &audioMothDeviceID : NULL;
+    captureDeviceConfig.capture.format = floatPipelineEnabled ? ma_format_f32 : ma_format_s16;
+    captureDeviceConfig.capture.channels = numberOfChannels;
+    captureDeviceConfig.capture.shareMode  = exclusiveModeEnabled ? ma_share_mode_exclusive : ma_share_mode_shared;
+
+    /* Exclusive mode on Linux opens the ALSA hw device and stops ALSA inserting its own conversion plugins */
+
+    captureDeviceConfig.alsa.noAutoFormat = exclusiveModeEnabled;
+    captureDeviceConfig.alsa.noAutoChannels = exclusiveModeEnabled;
+    captureDeviceConfig.alsa.noAutoResample = exclusiveModeEnabled;
+
+    inputDeviceSampleRate = usingAudioMoth ? audioMothSampleRate : maximumDefaultSampleRate;
+
+    sprintf(inputDeviceName, usingAudioMoth ? "%dkHz AudioMoth USB Microphone" : "%dkHz Default Input", inputDeviceSampleRate / HERTZ_IN_KILOHERTZ);
+
+    sprintf(inputDeviceCommentName, usingAudioMoth ? "a %dkHz AudioMoth USB Microphone" : "the %dkHz default input", inputDeviceSampleRate / HERTZ_IN_KILOHERTZ);
+
+    currentSampleRate = MIN(requestedSampleRate, inputDeviceSampleRate);
+
+    selectCaptureKernel();
+
+    Level_setBlockSize(inputDeviceSampleRate / LEVEL_BLOCKS_PER_SECOND * numberOfChannels);
+
+    captureDeviceConfig.sampleRate = inputDeviceSampleRate;
+    captureDeviceConfig.periodSizeInFrames = (ma_uint32)((int64_t)inputDeviceSampleRate * capturePeriodDuration / MILLISECONDS_IN_SECOND);
+    captureDeviceConfig.periods = capturePeriods;
+    captureDeviceConfig.dataCallback = capture_data_callback;
+    captureDeviceConfig.notificationCallback = capture_notification_callback;
+
+    ma_result result = ma_device_init(context, &captureDeviceConfig, &captureDevice);
+
+    if (result != MA_SUCCESS) return false;
+
+    /* Start the capture device */
+
+    result = ma_device_start(&captureDevice);
+
+    if (result != MA_SUCCESS) return false;
+
+    return true;
+
+}
+
+void stopMicrophone(void) {
+
+    ma_device_stop(&captureDevice);
+
+    ma_device_uninit(&captureDevice);
+        
+    memset(&captureDevice, 0, sizeof(ma_device));
+
+}
+
+/* Functions to start and stop playback device */
+
+static void startPlayback(void) {
+
+    pthread_mutex_lock(&playbackMutex);
+
+    if (playbackStarted) {
+
+        pthread_mutex_unlock(&playbackMutex);
+
+        return;
+
+    }
+
+    /* Initialise playback device */
+
+    ma_device_config playbackDeviceConfig = ma_device_config_init(ma_device_type_playback);
+
+    playbackDeviceConfig.playback.pDeviceID = NULL;
+    playbackDeviceConfig.playback.format = ma_format_s16;
+    playbackDeviceConfig.playback.channels = 1;
+
+    playbackDeviceConfig.sampleRate = PLAYBACK_SAMPLE_RATE;
+    playbackDeviceConfig.periodSizeInFrames = PLAYBACK_SAMPLE_RATE * capturePeriodDuration / MILLISECONDS_IN_SECOND;
+    playbackDeviceConfig.dataCallback = playback_data_callback;
+    playbackDeviceConfig.notificationCallback = NULL;
+
+    ma_result result = ma_device_init(&playbackContext, &playbackDeviceConfig, &playbackDevice);
+
+    if (result != MA_SUCCESS) {
+        
+        Logger_log(LG_ERROR, LG_PLAYBACK, "Failed to initialise playback device");
+
+        pthread_mutex_unlock(&playbackMutex);
+
+        return;
+
+    }
+
+    /* Start the playback device */
+
+    result = ma_device_start(&playbackDevice);
+
+    if (result == MA_SUCCESS) {
+
+        playbackStarted = true;
+
+    } else {
+
+        Logger_log(LG_ERROR, LG_PLAYBACK, "Failed to start playback device");
+
+        ma_device_uninit(&playbackDevice);
+
+    }
+
+    pthread_mutex_unlock(&playbackMutex);
+
+}
+
+static void stopPlayback(void) {
+
+    pthread_mutex_lock(&playbackMutex);
+
+    if (playbackStarted) {
+
+        ma_device_uninit(&playbackDevice);
+
+        memset(&playbackDevice, 0, sizeof(ma_device));
+
+        playbackStarted = false;
+
+    }
+
+    pthread_mutex_unlock(&playbackMutex);
+
+}
+
+static void *startPlaybackThreadBody(void *ptr) {
+
+    startPlayback();
+
+    return NULL;
+
+}
+
+/* Background and autosave functions */
+
+static void addAutosaveEvent(AS_event_type_t eventType) {
+
+    AS_event_t event;
+
+    event.type = eventType;
+
+    event.sampleRate = currentSampleRate;
+
+    event.duration = atomic_load_explicit(&autosaveDuration, memory_order_relaxed);
+
+    pthread_mutex_lock(&audioBufferMutex);
+
+    event.currentCount = autosaveSampleCount;
+    event.currentIndex = audioBufferWriteIndex;
+ 
+    event.startTime = autosaveStartTime;
+    event.startCount = autosaveStartSampleCount;
+
+    pthread_mutex_unlock(&audioBufferMutex);
+
+    event.deviceName = Autosave_internDeviceName(inputDeviceCommentName);
+
+    if (Autosave_addEvent(&event) == false) Logger_log(LG_ERROR, LG_AUTOSAVE, "Could not queue autosave event");
+
+}
+
+/* Private function */
+
+static void formatFileTime(char *buffer, time_t start, time_t stop, int32_t timeOffset) {
+
+    struct tm time;
+
+    time_t rawTime = start + timeOffset;
+
+    Time_gmTime(&rawTime, &time);
+
+    buffer += sprintf(buffer, "%02d:%02d:%02d to ", time.tm_hour, time.tm_min, time.tm_sec);
+
+    rawTime = stop + timeOffset;
+
+    Time_gmTime(&rawTime, &time);
+
+    buffer += sprintf(buffer, "%02d:%02d:%02d (UTC", time.tm_hour, time.tm_min, time.tm_sec);
+
+    int32_t timeOffsetMinutes = timeOffset / SECONDS_IN_MINUTE;
+
+    int32_t timezoneHours = timeOffsetMinutes / MINUTES_IN_HOUR;
+
+    int32_t timezoneMinutes = timeOffsetMinutes % MINUTES_IN_HOUR;
+
+    if (timezoneHours < 0) {
+
+        buffer += sprintf(buffer, "%d", timezoneHours);
+
+    } else if (timezoneHours > 0) {
+
+        buffer += sprintf(buffer, "+%d", timezoneHours);
+
+    } else {
+
+        if (timezoneMinutes < 0) buffer += sprintf(buffer, "-0");
+
+        if (timezoneMinutes > 0) buffer += sprintf(buffer, "+0");
+
+    }
+
+    if (timezoneMinutes < 0) buffer += sprintf(buffer, ":%02d", -timezoneMinutes);
+
+    if (timezoneMinutes > 0) buffer += sprintf(buffer, ":%02d", timezoneMinutes);
+
+    sprintf(buffer, ")");
+
+}
+
+/* Functions to record the file being written and repair it after a crash */
+
+static void getRecoveryMarkerFilename(char *filename) {
+
+    snprintf(filename, RECOVERY_MARKER_FILENAME_SIZE, "%s%s%s", fileDestination, FILE_SEPARATOR, RECOVERY_MARKER_NAME);
+
+}
+
+static void writeRecoveryMarker(void) {
+
+    static char markerFilename[RECOVERY_MARKER_FILENAME_SIZE];
+
+    getRecoveryMarkerFilename(markerFilename);
+
+    FILE *markerFile = fopen(markerFilename, "w");
+
+    if (markerFile == NULL) return;
+
+    /* Record the logical length as the file size includes the padding of the last direct I/O block */
+
+    fprintf(markerFile, "%s\n%lld\n", autosaveFilename, (long long)autosaveFileLength);
+
+    fclose(markerFile);
+
+}
+
+static void removeRecoveryMarker(void) {
+
+    static char markerFilename[RECOVERY_MARKER_FILENAME_SIZE];
+
+    if (autosaveDurability == WAV_SYNC_NONE) return;
+
+    getRecoveryMarkerFilename(markerFilename);
+
+    remove(markerFilename);
+
+}
+
+static void recoverAutosaveFile(void) {
+
+    static char markerFilename[RECOVERY_MARKER_FILENAME_SIZE];
+
+    static char recoveryFilename[FILENAME_SIZE];
+
+    getRecoveryMarkerFilename(markerFilename);
+
+    FILE *markerFile = fopen(markerFilename, "r");
+
+    if (markerFile == NULL) return;
+
+    bool found = fgets(recoveryFilename, FILENAME_SIZE, markerFile) != NULL;
+
+    recoveryFilename[strcspn(recoveryFilename, "\n")] = 0;
+
+    long long length = 0;
+
+    if (found && fscanf(markerFile, "%lld", &length) != 1) length = 0;
+
+    fclose(markerFile);
+
+    bool repaired = false;
+
+    if (found && WavFile_repairFile(recoveryFilename, length, &repaired) && repaired) Logger_log(LG_WARNING, LG_RECOVERY, "Repaired header of %s", recoveryFilename);
+
+    remove(markerFilename);
+
+}
+
+static void saveRecoveredSamples(PR_recovery_t *recovery) {
+
+    static WAV_header_t recoveryHeader;
+
+    static char recoveryFilename[FILENAME_SIZE];
+
+    if (recovery->numberOfSamples == 0) return;
+
+    int32_t localTimeOffset = useLocalTime ? Time_getLocalTimeOffset() : 0;
+
+    int32_t currentTime = (int32_t)(recovery->startTime / MILLISECONDS_IN_SECOND) + localTimeOffset;
+
+    int32_t milliseconds = (int32_t)(recovery->startTime % MILLISECONDS_IN_SECOND);
+
+    WavFile_initialiseHeader(&recoveryHeader);
+
+    WavFile_setHeaderDetails(&recoveryHeader, recovery->sampleRate, recovery->numberOfSamples);
+
+    WavFile_setFilename(recoveryFilename, currentTime, milliseconds, fileDestination, directoryLayout);
+
+    /* Split the unflushed samples at the end of the buffer */
+
+    int32_t numberOfSamples1 = MIN(recovery->numberOfSamples, audioBufferFrames - recovery->startIndex);
+
+    int32_t numberOfSamples2 = recovery->numberOfSamples - numberOfSamples1;
+
+    /* Add the levels of the recovered samples to the comment */
+
+    LV_levels_t levels;
+
+    Level_reset(&levels);
+
+    Level_measure(&levels, audioBuffer + recovery->startIndex, numberOfSamples1, false);
+
+    Level_measure(&levels, audioBuffer, numberOfSamples2, false);
+
+    WavFile_setHeaderComment(&recoveryHeader, currentTime, milliseconds, localTimeOffset, RECOVERED_DEVICE_NAME);
+
+    WavFile_addHeaderLevels(&recoveryHeader, Level_getPeakDecibels(&levels), Level_getRMSDecibels(&levels), levels.clippedSamples);
+
+    bool success = WavFile_writeFile(&recoveryHeader, recoveryFilename, audioBuffer + recovery->startIndex, numberOfSamples1, audioBuffer, numberOfSamples2, 0);
+
+    if (success) {
+
+        Logger_log(LG_WARNING, LG_RECOVERY, "Saved %d unwritten samples to %s", recovery->numberOfSamples, recoveryFilename);
+
+    } else {
+
+        Logger_log(LG_ERROR, LG_RECOVERY, "Could not save unwritten samples from persistent buffer");
+
+    }
+
+}
+
+static void releaseAutosaveFile(void) {
+
+    if (autosaveFileNeedsRelease) WavFile_releaseFile(autosaveFilename);
+
+    autosaveFileNeedsRelease = false;
+
+    /* The file is complete so there is nothing left to repair */
+
+    removeRecoveryMarker();
+
+}
+
+static void *getAutosaveSamples(int32_t index) {
+
+    if (floatPipelineEnabled) return floatAudioBuffer + (size_t)index * numberOfChannels;
+
+    if (channelAudioBuffer != NULL) return channelAudioBuffer + (size_t)index * numberOfChannels;
+
+    return audioBuffer + index;
+
+}
+
+static void measureAutosaveSamples(LV_levels_t *levels, int32_t index, int32_t numberOfSamples) {
+
+    Level_measure(levels, getAutosaveSamples(index), numberOfSamples * numberOfChannels, floatPipelineEnabled);
+
+}
+
+static bool writeAutosaveFile(int32_t duration, int32_t period) {
+
+    bool success = false;
+
+    static WAV_header_t autosaveHeader;
+
+    static char autosaveFileComment[LENGTH_OF_COMMENT];
+
+    static LV_levels_t autosaveFileLevels;
+
+    static int32_t previousLocalTimeOffset = 0;
+
+    static time_t autosaveFilePreviousStopTime = 0;
+
+    if (duration == 0) return true;
+
+    /* Read local time offset */
+
+    int32_t localTimeOffset = useLocalTime ? Time_getLocalTimeOffset() : 0;
+
+    /* Determine whether file should be appended */
+
+    struct tm timeStart;
+
+    time_t rawTimeStart = autosaveFileStartTime;
+
+    Time_gmTime(&rawTimeStart, &timeStart);
+    
+    bool append = localTimeOffset == previousLocalTimeOffset;
+    
+    append &= autosaveFileStartTime == autosaveFilePreviousStopTime;
+
+    append &= timeStart.tm_sec == 0 && period > 0 && timeStart.tm_min % period > 0;
+
+    autosaveFilePreviousStopTime = autosaveFileStartTime + duration;
+
+    previousLocalTimeOffset = localTimeOffset;
+
+    /* Remove old files first so a full card can recover before the next write */
+
+    if (Retention_enforce(time(NULL)) == false) Logger_log(LG_ERROR, LG_RETENTION, "Could not remove old WAV file");
+
+    /* Write the output WAV file */
+
+    double writeStartTime = ma_timer_get_time_in_seconds(&timer);
+
+    int32_t numberOfSamples = duration * autosaveFileSampleRate;
+
+    int32_t overlap = autosaveFileStartIndex + numberOfSamples - audioBufferFrames;
+
+    /* Measure the levels of the samples being written */
+
+    LV_levels_t writeLevels;
+
+    Level_reset(&writeLevels);
+
+    if (overlap < 0) {
+
+        measureAutosaveSamples(&writeLevels, autosaveFileStartIndex, numberOfSamples);
+
+    } else {
+
+        measureAutosaveSamples(&writeLevels, autosaveFileStartIndex, numberOfSamples - overlap);
+
+        measureAutosaveSamples(&writeLevels, 0, overlap);
+
+    }
+
+    if (append == true) {
+
+        /* Update the comment with the levels of the whole file */
+
+        LV_levels_t fileLevels = autosaveFileLevels;
+
+        Level_combine(&fileLevels, &writeLevels);
+
+        memcpy(autosaveHeader.icmt.comment, autosaveFileComment, LENGTH_OF_COMMENT);
+
+        WavFile_addHeaderLevels(&autosaveHeader, Level_getPeakDecibels(&fileLevels), Level_getRMSDecibels(&fileLevels), fileLevels.clippedSamples);
+
+        if (overlap < 0) {
+
+            success = WavFile_appendFile(autosaveFilename, autosaveHeader.icmt.comment, getAutosaveSamples(autosaveFileStartIndex), numberOfSamples, NULL, 0);
+
+        } else {
+
+            success = WavFile_appendFile(autosaveFilename, autosaveHeader.icmt.comment, getAutosaveSamples(autosaveFileStartIndex), numberOfSamples - overlap, getAutosaveSamples(0), overlap);
+
+        }
+
+        if (success) autosaveFileLevels = fileLevels;
+
+    }
+
+    bool appended = append && success;
+
+    if (append == false || success == false) {
+
+        /* Release any unused space reserved for the previous file */
+
+        releaseAutosaveFile();
+
+        /* Preallocate up to the end of the current autosave period */
+
+        int32_t numberOfSamplesToPreallocate = 0;
+
+        if (autosavePreallocationEnabled && period > 0) {
+
+            int32_t periodDuration = period * SECONDS_IN_MINUTE;
+
+            int32_t remainingDuration = periodDuration - (int32_t)(autosaveFileStartTime % periodDuration);
+
+            numberOfSamplesToPreallocate = MAX(numberOfSamples, remainingDuration * autosaveFileSampleRate);
+
+        }
+
+        WavFile_initialiseHeader(&autosaveHeader);
+
+        WavFile_setHeaderDetails(&autosaveHeader, autosaveFileSampleRate, numberOfSamples);
+
+        WavFile_setHeaderComment(&autosaveHeader, (int32_t)autosaveFileStartTime + localTimeOffset, -1, localTimeOffset, autosaveInputDeviceCommentName);
+
+        memcpy(autosaveFileComment, autosaveHeader.icmt.comment, LENGTH_OF_COMMENT);
+
+        WavFile_addHeaderLevels(&autosaveHeader, Level_getPeakDecibels(&writeLevels), Level_getRMSDecibels(&writeLevels), writeLevels.clippedSamples);
+
+        autosaveFileLevels = writeLevels;
+
+        WavFile_setFilename(autosaveFilename, (int32_t)autosaveFileStartTime + localTimeOffset, -1, fileDestination, directoryLayout);
+
+        if (overlap < 0) {
+
+            success = WavFile_writeFile(&autosaveHeader, autosaveFilename, getAutosaveSamples(autosaveFileStartIndex), numberOfSamples, NULL, 0, numberOfSamplesToPreallocate);
+
+        } else {
+
+            success = WavFile_writeFile(&autosaveHeader, autosaveFilename, getAutosaveSamples(autosaveFileStartIndex), numberOfSamples - overlap, getAutosaveSamples(0), overlap, numberOfSamplesToPreallocate);
+
+        }
+
+        /* Preallocated space and the padding of the last direct I/O block are both removed when the file is finished */
+
+        autosaveFileNeedsRelease = success && (numberOfSamplesToPreallocate > 0 || autosaveDirectWriterEnabled);
+
+    }
+
+    /* Update metrics */
+
+    Metrics_set(MT_FILE_WRITE_LATENCY, (int64_t)((ma_timer_get_time_in_seconds(&timer) - writeStartTime) * MICROSECONDS_IN_SECOND));
+
+    if (success) {
+
+        Metrics_add(MT_FILES_WRITTEN, 1);
+
+        Metrics_add(MT_SAMPLES_WRITTEN, numberOfSamples);
+
+    }
+
+    /* Update retention index and recovery marker */
+
+    if (success) {
+
+        int64_t numberOfBytes = (int64_t)WavFile_getBytesPerFrame() * numberOfSamples;
+
+        if (appended) {
+
+            Retention_updateFile(autosaveFilename, numberOfBytes);
+
+            autosaveFileLength += numberOfBytes;
+
+        } else {
+
+            Retention_addFile(autosaveFilename, WavFile_getHeaderSize() + numberOfBytes, autosaveFileStartTime);
+
+            autosaveFileLength = WavFile_getHeaderSize() + numberOfBytes;
+
+        }
+
+        if (autosaveDurability != WAV_SYNC_NONE) writeRecoveryMarker();
+
+    }
+
+    /* Log output file */
+
+    static char buffer[FILE_TIME_BUFFER_SIZE];
+
+    formatFileTime(buffer, autosaveFileStartTime, autosaveFilePreviousStopTime, localTimeOffset);
+
+    Logger_log(LG_INFO, LG_AUTOSAVE, "%s", buffer);
+
+    /* Return status */
+
+    return success;
+
+}
+
+static bool makeMinuteTransitionRecording(int32_t period) {
+
+    /* Generate partial recording */
+
+    int64_t sampleCountDifference = autosaveTargetCount - autosaveFileStartCount;
+
+    int32_t duration = (int32_t)(sampleCountDifference / autosaveFileSampleRate);
+
+    bool success = writeAutosaveFile(duration, period);
+
+    /* Update for next minute transition */
+
+    autosaveFileStartTime += duration;
+
+    autosaveFileStartIndex = (autosaveFileStartIndex + sampleCountDifference) % audioBufferFrames;
+
+    autosaveFileStartCount = autosaveTargetCount;
+
+    autosaveTargetCount = autosaveFileStartCount + SECONDS_IN_MINUTE * autosaveFileSampleRate;
+
+    return success;
+
+}
+
+static void updateForMillisecondOffset(int32_t milliseconds) {
+
+    /* Update count, index and time for millisecond offset */
+
+    if (milliseconds > 0) {
+        
+        int32_t millisecondOffset = MILLISECONDS_IN_SECOND - milliseconds;
+
+        int32_t sampleOffset = ROUNDED_DIV(autosaveFileSampleRate * millisecondOffset, MILLISECONDS_IN_SECOND);
+
+        autosaveFileStartCount += sampleOffset;
+
+        autosaveFileStartIndex = (autosaveFileStartIndex + sampleOffset) % audioBufferFrames;
+
+        autosaveFileStartTime += 1;
+
+    }
+
+    /* Calculate target sample count for the next minute transition */
+
+    struct tm time;
+
+    time_t rawTime = autosaveFileStartTime;
+
+    Time_gmTime(&rawTime, &time);
+
+    autosaveTargetCount = autosaveFileStartCount + (SECONDS_IN_MINUTE - time.tm_sec) * autosaveFileSampleRate;
+
+}
+
+static void *backgroundThreadBody(void *ptr) {
+
+    static AS_event_t events[AUTOSAVE_EVENT_QUEUE_SIZE];
+    
+    while (true) {
+
+        /* Check for AudioMoth */
+
+        pthread_mutex_lock(&backgroundDeviceCheckMutex);
+
+        double enumerationStartTime = ma_timer_get_time_in_seconds(&timer);
+
+        device_check_t device_check = checkForAudioMoth(&deviceCheckContext, false);
+
+        Metrics_set(MT_ENUMERATION_TIME, (int64_t)((ma_timer_get_time_in_seconds(&timer) - enumerationStartTime) * MICROSECONDS_IN_SECOND));
+
+        bool audioMothFound = device_check.audioMothFound;
+        
+        bool oldAudioMothFound = device_check.oldAudioMothFound;
+
+        pthread_mutex_unlock(&backgroundDeviceCheckMutex);
+
+        pthread_mutex_lock(&backgroundMutex);
+
+        backgroundDeviceCheckTime = ma_timer_get_time_in_seconds(&timer);
+
+        backgroundDeviceCheckFoundAudioMoth = audioMothFound;
+
+        backgroundDeviceCheckFoundOldAudioMoth = oldAudioMothFound;
+
+        pthread_mutex_unlock(&backgroundMutex);
+
+        /* Get current sample count and autosave duration */
+
+        pthread_mutex_lock(&audioBufferMutex);
+
+        int64_t currentSampleCount = autosaveSampleCount;
+
+        pthread_mutex_unlock(&audioBufferMutex);
+
+        /* Process autosave events */
+
+        bool success = true;
+
+        int32_t numberOfEvents = Autosave_getEvents(events, AUTOSAVE_EVENT_QUEUE_SIZE);
+
+        for (int32_t i = 0; i < numberOfEvents; i += 1) {
+
+            AS_event_t event = events[i];
+
+            /* Process event */
+
+            if (autosaveWaitingForStartEvent && event.type == AS_START) {
+
+                /* Set sample rate and device */
+
+                autosaveFileSampleRate = event.sampleRate;
+
+                memcpy(autosaveInputDeviceCommentName, Autosave_getDeviceName(event.deviceName), DEVICE_NAME_SIZE);
+
+                /* Adjust start time to match current count and index */
+
+                int64_t countDifference = event.currentCount - event.startCount;
+
+                int64_t updatedStartTime = event.startTime + ROUNDED_DIV(countDifference * MILLISECONDS_IN_SECOND, autosaveFileSampleRate);
+
+                int32_t milliseconds = updatedStartTime % MILLISECONDS_IN_SECOND;
+
+                autosaveFileStartTime = updatedStartTime / MILLISECONDS_IN_SECOND;
+
+                autosaveFileStartCount = event.currentCount;
+
+                autosaveFileStartIndex = event.currentIndex;
+
+                /* Update start time, count and index for millisecond offset */
+
+                updateForMillisecondOffset(milliseconds); 
+
+                /* Reset flag */
+                
+                autosaveWaitingForStartEvent = false;
+
+            }
+
+            /* Use the autosave duration in force when the event was queued as the control socket may since have changed it */
+
+            if (currentSampleCount >= autosaveTargetCount && autosaveTargetCount < event.currentCount) {
+
+                success &= makeMinuteTransitionRecording(event.duration);
+
+            }
+
+            if (event.type == AS_RESTART) {
+
+                /* Write samples since last start to file */
+
+                int32_t duration = (int32_t)(event.startCount - autosaveFileStartCount) / autosaveFileSampleRate;
+
+                success &= writeAutosaveFile(duration, event.duration);
+
+                /* Set sample rate and device */
+
+                autosaveFileSampleRate = event.sampleRate;
+
+                memcpy(autosaveInputDeviceCommentName, Autosave_getDeviceName(event.deviceName), DEVICE_NAME_SIZE);
+
+                /* Adjust current index to match start time and count */
+
+                int32_t milliseconds = event.startTime % MILLISECONDS_IN_SECOND;
+
+                autosaveFileStartTime = event.startTime / MILLISECONDS_IN_SECOND;
+
+                autosaveFileStartCount = event.startCount;
+
+                int64_t countDifference = (event.currentCount - event.startCount);
+
+                autosaveFileStartIndex = (audioBufferFrames + event.currentIndex - countDifference) % audioBufferFrames;
+
+                /* Update start time, count and index for millisecond offset */
+
+                updateForMillisecondOffset(milliseconds);
+
+            }
+
+            if (event.type == AS_STOP) {
+
+                /* Write samples since last start to file */
+
+                int32_t duration = (int32_t)(event.currentCount - autosaveFileStartCount) / autosaveFileSampleRate;
+
+                success &= writeAutosaveFile(duration, event.duration);
+
+                releaseAutosaveFile();
+
+                /* Reset flags */
+
+                autosaveWaitingForStartEvent = true;
+
+                autosaveTargetCount = INT64_MAX;
+
+            }
+
+            if (event.type == AS_SHUTDOWN) {
+
+                if (autosaveWaitingForStartEvent == false) {
+
+                    /* Write samples since last start to file */
+
+                    int32_t duration = (int32_t)(event.currentCount - autosaveFileStartCount) / autosaveFileSampleRate;
+
+                    writeAutosaveFile(duration, event.duration);
+
+                    releaseAutosaveFile();
+
+                }
+
+                pthread_mutex_lock(&autosaveMutex);
+
+                autosaveShutdownCompleted = true;
+
+                pthread_mutex_unlock(&autosaveMutex);
+
+                /* Reset flags */
+
+                autosaveWaitingForStartEvent = true;
+
+                autosaveTargetCount = INT64_MAX;
+
+            }
+
+        }
+
+        if (currentSampleCount >= autosaveTargetCount) {
+
+            success &= makeMinuteTransitionRecording(atomic_load_explicit(&autosaveDuration, memory_order_relaxed));
+
+        }
+
+        /* Update writer lag metrics */
+
+        int64_t writerLag = autosaveWaitingForStartEvent ? 0 : MAX(0, currentSampleCount - autosaveFileStartCount);
+
+        Metrics_set(MT_WRITER_LAG, writerLag);
+
+        Metrics_set(MT_RING_FILL, MIN(writerLag, audioBufferFrames) * METRICS_RATIO_SCALE / audioBufferFrames);
+
+        /* Record how much of the persistent ring buffer has reached a WAV file */
+
+        PersistentRing_setFlushedCount(autosaveWaitingForStartEvent ? currentSampleCount : autosaveFileStartCount);
+
+        PersistentRing_sync();
+
+        /* Thread safe callback */
+
+        if (success == false) {
+
+            Logger_log(LG_ERROR, LG_AUTOSAVE, "Could not write WAV file");
+
+        }
+
+        /* Calculate delay period to wait for next update */
+
+        uint32_t microseconds = Time_getMicroseconds();
+
+        uint32_t delay = DEVICE_CHECK_INTERVAL - microseconds % DEVICE_CHECK_INTERVAL;
+
+        usleep(delay);
+
+    }
+
+    return NULL;
+
+}
+
+/* Interrupt handler */
+
+void Signal_handleSignal(void) {
+
+    success = false;
+
+}
+
+/* Argument parsing functions */
+
+static bool parseArgument(char *pattern, char *text) {
+
+    static char buffer[ARGUMENT_BUFFER_SIZE];
+
+    for (int32_t i = 0; i < ARGUMENT_BUFFER_SIZE; i += 1) {
+
+        buffer[i] = toupper(text[i]);
+
+        if (buffer[i] == 0) break;
+
+    }
+
+    return strncmp(pattern, buffer, ARGUMENT_BUFFER_SIZE) == 0;
+
+}
+
+static bool parseNumber(char *text, int32_t *number) {
+
+    for (int32_t i = 0; i < ARGUMENT_BUFFER_SIZE; i += 1) {
+
+        char character = text[i];
+
+        if (character == 0) break;
+
+        if (character < '0' || character > '9') return false;
+
+    }
+
+    if (number != NULL) *number = atoi(text);
+
+    return true;
+
+}
+
+static bool checkNumberAgainstList(int32_t value, int32_t *validNumbers, int32_t length) {
+
+    for (int32_t i = 0; i < length; i += 1) {
+
+        if (value == validNumbers[i]) return true;
+
+    }
+
+    return false;
+
+}
+
+static bool parseNumberAgainstList(char *text, int32_t *validNumbers, int32_t length, int32_t *number) {
+
+    int32_t value;
+
+    bool isNumber = parseNumber(text, &value);
+
+    if (isNumber == false) return false;
+
+    if (checkNumberAgainstList(value, validNumbers, length) == false) return false;
+
+    *number = value;
+
+    return true;
+
+}
+
+/* Control socket handler */
+
+static bool handleControlCommand(CT_command_t *command, char *response) {
+
+    int32_t value = command->value;
+
+    if (command->type == CT_STATUS) {
+
+        LV_levels_t levels;
+
+        if (Level_getLatestBlock(&levels) == false) Level_reset(&levels);
+
+        pthread_mutex_lock(&playbackMutex);
+
+        bool started = playbackStarted;
+
+        pthread_mutex_unlock(&playbackMutex);
+
+        snprintf(response, CONTROL_RESPONSE_SIZE, "SAMPLERATE %d MONITOR %s HETERODYNE %d AUTOSAVE %d PEAK %.1f RMS %.1f CLIPPED %lld", currentSampleRate, started ? "ON" : "OFF", monitorMode == MONITOR_HETERODYNE ? heterodyneFrequency : 0, (int32_t)atomic_load_explicit(&autosaveDuration, memory_order_relaxed), Level_getPeakDecibels(&levels), Level_getRMSDecibels(&levels), (long long)Level_getClippedSamples());
+
+        return true;
+
+    }
+
+    if (command->type == CT_SAMPLE_RATE) {
+
+        if (checkNumberAgainstList(value, validSampleRates, NUMBER_OF_VALID_SAMPLE_RATES) == false) {
+
+            snprintf(response, CONTROL_RESPONSE_SIZE, "Invalid sample rate.");
+
+            return false;
+
+        }
+
+        if (monitorMode == MONITOR_HETERODYNE && heterodyneFrequency > value / 2) {
+
+            snprintf(response, CONTROL_RESPONSE_SIZE, "Sample rate is too low for heterodyne frequency.");
+
+            return false;
+
+        }
+
+        if ((int64_t)value * MINIMUM_BUFFER_DURATION > audioBufferFrames) {
+
+            snprintf(response, CONTROL_RESPONSE_SIZE, "Sample rate is too high for the number of channels.");
+
+            return false;
+
+        }
+
+        /* The main loop restarts the device and sends the restart autosave event */
+
+        pthread_mutex_lock(&backgroundMutex);
+
+        requestedSampleRate = value;
+
+        backgroundRestartRequested = true;
+
+        pthread_mutex_unlock(&backgroundMutex);
+
+        return true;
+
+    }
+
+    if (command->type == CT_HETERODYNE) {
+
+        if (value < MINIMUM_HETERODYNE_FREQUENCY || value > currentSampleRate / 2) {
+
+            snprintf(response, CONTROL_RESPONSE_SIZE, "Invalid heterodyne frequency.");
+
+            return false;
+
+        }
+
+        if (monitorMode == MONITOR_FREQUENCY_DIVISION || monitorMode == MONITOR_TIME_EXPANSION) {
+
+            snprintf(response, CONTROL_RESPONSE_SIZE, "Could not use heterodyne while %s is active.", monitorMode == MONITOR_FREQUENCY_DIVISION ? "frequency division" : "time expansion");
+
+            return false;
+
+        }
+
+        heterodyneFrequency = value;
+
+        /* The frequency is posted before the mode changes so the playback callback never mixes with stale coefficients */
+
+        atomic_store_explicit(&heterodyneRequest, heterodyneFrequency, memory_order_release);
+
+        if (monitorMode == MONITOR_NORMAL) {
+
+            monitorMode = MONITOR_HETERODYNE;
+
+            snprintf(response, CONTROL_RESPONSE_SIZE, "Monitor mode changed to heterodyne.");
+
+        }
+
+        return true;
+
+    }
+
+    if (command->type == CT_MONITOR) {
+
+        if (value) startPlayback(); else stopPlayback();
+
+        pthread_mutex_lock(&playbackMutex);
+
+        bool started = playbackStarted;
+
+        pthread_mutex_unlock(&playbackMutex);
+
+        return started == (value == 1);
+
+    }
+
+    if (command->type == CT_AUTOSAVE) {
+
+        if (checkNumberAgainstList(value, validAutosaveDurations, NUMBER_OF_VALID_AUTOSAVE_DURATIONS) == false) {
+
+            snprintf(response, CONTROL_RESPONSE_SIZE, "Invalid autosave duration.");
+
+            return false;
+
+        }
+
+        if (autosaveDuration == 0 && value > 0) {
+
+            autosaveDuration = value;
+
+            addAutosaveEvent(AS_START);
+
+        } else if (autosaveDuration > 0 && value == 0) {
+
+            addAutosaveEvent(AS_STOP);
+
+            autosaveDuration = 0;
+
+        } else {
+
+            autosaveDuration = value;
+
+        }
+
+        return true;
+
+    }
+
+    return false;
+
+}
+
+/* Function to show the latest capture levels */
+
+static void showLevelMeter(void) {
+
+    static int64_t previousLogTime = 0;
+
+    static int64_t previousClippedSamples = 0;
+
+    LV_levels_t levels;
+
+    if (Level_getLatestBlock(&levels) == false) return;
+
+    double peakLevel = Level_getPeakDecibels(&levels);
+
+    double rmsLevel = Level_getRMSDecibels(&levels);
+
+    int64_t clippedSamples = Level_getClippedSamples();
+
+    /* Structured logs get one entry a second rather than a redrawn line */
+
+    if (logFormat == LG_JSON) {
+
+        int64_t currentTime = Time_getMillisecondUTC();
+
+        if (currentTime - previousLogTime < METER_LOG_INTERVAL) return;
+
+        Logger_log(LG_INFO, LG_CAPTURE, "Peak %.1f dBFS, RMS %.1f dBFS, %lld clipped samples.", peakLevel, rmsLevel, (long long)clippedSamples);
+
+        previousLogTime = currentTime;
+
+        return;
+
+    }
+
+    /* Draw the RMS level as a solid bar extended to the peak level */
+
+    static char bar[METER_WIDTH + 1];
+
+    int32_t rmsLength = (int32_t)round((rmsLevel - METER_FLOOR) * METER_WIDTH / -METER_FLOOR);
+
+    int32_t peakLength = (int32_t)round((peakLevel - METER_FLOOR) * METER_WIDTH / -METER_FLOOR);
+
+    rmsLength = MAX(0, MIN(METER_WIDTH, rmsLength));
+
+    peakLength = MAX(0, MIN(METER_WIDTH, peakLength));
+
+    for (int32_t i = 0; i < METER_WIDTH; i += 1) bar[i] = i < rmsLength ? '#' : i < peakLength ? '-' : ' ';
+
+    bar[METER_WIDTH] = 0;
+
+    static char line[METER_LINE_SIZE];
+
+    int32_t length = snprintf(line, METER_LINE_SIZE, "[%s] Peak %6.1f dBFS  RMS %6.1f dBFS  Clipped %lld%s", bar, peakLevel, rmsLevel, (long long)clippedSamples, clippedSamples > previousClippedSamples ? " CLIP" : "     ");
+
+    /* Log messages blank the meter line before they are written and the meter is redrawn below them */
+
+    Logger_setStatusWidth(MIN(length, METER_LINE_SIZE - 1));
+
+    printf("\r%s", line);
+
+    fflush(stdout);
+
+    previousClippedSamples = clippedSamples;
+
+}
+
+/* Exported functions */
+
+int main(int argc, char **argv) {
+
+    success = true;
+
+    CPU_instructionSet_t instructionSet = CPU_getInstructionSet();
+
+    printf("AudioMoth-Live 1.0.0 (%s)\n", CPU_getInstructionSetName(instructionSet));
+
+    WavFile_setInstructionSet(instructionSet);
+
+    Level_setInstructionSet(instructionSet);
+
+    /* Set default file destination */
+
+    strncpy(fileDestination, ".", FILE_DESTINATION_SIZE);
+
+    /* Parse arguments */
+
+    bool parseError = false;
+
+    int32_t argumentCounter = 1;
+
+    int32_t possibleFileDestinationCount = 0;
+
+    while (argumentCounter < argc) {
+
+        char *argument = argv[argumentCounter];
+
+        if (argumentCounter == possibleFileDestinationCount) {
+
+            bool exists = Directory_exists(argument);
+
+            if (exists) {
+
+                strncpy(fileDestination, argument, FILE_DESTINATION_SIZE);
+
+                argumentCounter += 1;
+
+                continue;
+
+            }
+
+        }
+
+        if (parseArgument("HIGHSAMPLERATE", argument) || parseArgument("HSR", argument)) {
+            
+            maximumDefaultSampleRate = MAXIMUM_SAMPLE_RATE;
+
+        } else if (parseArgument("UTC", argument)) {
+            
+            useLocalTime = false;
+
+        } else if (parseArgument("SYNC", argument)) {
+
+            argumentCounter += 1;
+
+            argument = argv[argumentCounter];
+
+            int32_t syncInterval = 0;
+
+            if (argumentCounter < argc && parseArgument("APPEND", argument)) {
+
+                autosaveDurability = WAV_SYNC_APPEND;
+
+            } else {
+
+                autosaveDurability = WAV_SYNC_INTERVAL;
+
+                parseError = argumentCounter == argc || parseNumber(argument, &syncInterval) == false || syncInterval == 0;
+
+            }
+
+            WavFile_setDurability(autosaveDurability, syncInterval);
+
+        } else if (parseArgument("LOG", argument)) {
+
+            argumentCounter += 1;
+
+            argument = argv[argumentCounter];
+
+            parseError = argumentCounter == argc;
+
+            if (parseError == false && parseArgument("HUMAN", argument)) {
+
+                logFormat = LG_HUMAN;
+
+            } else if (parseError == false && parseArgument("JSON", argument)) {
+
+                logFormat = LG_JSON;
+
+            } else {
+
+                parseError = true;
+
+            }
+
+        } else if (parseArgument("WAVFORMAT", argument)) {
+
+            argumentCounter += 1;
+
+            argument = argv[argumentCounter];
+
+            parseError = argumentCounter == argc;
+
+            if (parseError == false && parseArgument("16", argument)) {
+
+                wavFileFormat = WAV_INT16;
+
+            } else if (parseError == false && parseArgument("24", argument)) {
+
+                wavFileFormat = WAV_INT24;
+
+            } else if (parseError == false && parseArgument("FLOAT", argument)) {
+
+                wavFileFormat = WAV_FLOAT32;
+
+            } else {
+
+                parseError = true;
+
+            }
+
+            floatPipelineEnabled = wavFileFormat != WAV_INT16;
+
+        } else if (parseArgument("CHANNELS", argument)) {
+
+            argumentCounter += 1;
+
+            argument = argv[argumentCounter];
+
+            parseError = argumentCounter == argc || parseNumber(argument, &numberOfChannels) == false || numberOfChannels < 1 || numberOfChannels > MAXIMUM_NUMBER_OF_CHANNELS;
+
+        } else if (parseArgument("DSP", argument)) {
+
+            argumentCounter += 1;
+
+            argument = argv[argumentCounter];
+
+            parseError = argumentCounter == argc;
+
+            if (parseError == false && parseArgument("FIXED", argument)) {
+
+                fixedPointEnabled = true;
+
+            } else if (parseError == false && parseArgument("DOUBLE", argument)) {
+
+                fixedPointEnabled = false;
+
+            } else {
+
+                parseError = true;
+
+            }
+
+        } else if (parseArgument("METER", argument)) {
+
+            meterEnabled = true;
+
+        } else if (parseArgument("EXCLUSIVE", argument)) {
+
+            exclusiveModeEnabled = true;
+
+        } else if (parseArgument("PERIODS", argument)) {
+
+            argumentCounter += 1;
+
+            argument = argv[argumentCounter];
+
+            parseError = argumentCounter == argc || parseNumber(argument, &capturePeriods) == false || capturePeriods < MINIMUM_CAPTURE_PERIODS || capturePeriods > MAXIMUM_CAPTURE_PERIODS;
+
+        } else if (parseArgument("PERIODSIZE", argument)) {
+
+            argumentCounter += 1;
+
+            argument = argv[argumentCounter];
+
+            parseError = argumentCounter == argc || parseNumber(argument, &capturePeriodDuration) == false || capturePeriodDuration < MINIMUM_CAPTURE_PERIOD_DURATION || capturePeriodDuration > MAXIMUM_CAPTURE_PERIOD_DURATION;
+
+        } else if (parseArgument("WRITER", argument)) {
+
+            argumentCounter += 1;
+
+            argument = argv[argumentCounter];
+
+            parseError = argumentCounter == argc;
+
+            if (parseError == false && parseArgument("STDIO", argument)) {
+
+                WavFile_setWriter(WAV_STDIO_WRITER);
+
+            } else if (parseError == false && parseArgument("MAPPED", argument)) {
+
+                WavFile_setWriter(WAV_MAPPED_WRITER);
+
+            } else if (parseError == false && parseArgument("DIRECT", argument)) {
+
+                autosaveDirectWriterEnabled = true;
+
+                WavFile_setWriter(WAV_DIRECT_WRITER);
+
+            } else if (parseError == false && parseArgument("DONTNEED", argument)) {
+
+                WavFile_setWriter(WAV_DONTNEED_WRITER);
+
+            } else {
+
+                parseError = true;
+
+            }
+
+        } else if (parseArgument("PREALLOCATE", argument)) {
+
+            autosavePreallocationEnabled = true;
+
+        } else if (parseArgument("DAILYFOLDERS", argument)) {
+
+            directoryLayout = WAV_DAILY_LAYOUT;
+
+        } else if (parseArgument("HOURLYFOLDERS", argument)) {
+
+            directoryLayout = WAV_HOURLY_LAYOUT;
+
+        } else if (parseArgument("AUTOSAVE", argument)) {
+
+            argumentCounter += 1;
 
-        uint32_t delay = DEVICE_CHECK_INTERVAL - microseconds % DEVICE_CHECK_INTERVAL;
+            argument = argv[argumentCounter];
 
-        usleep(delay);
+            possibleFileDestinationCount = argumentCounter + 1;
+        
+            int32_t duration = 0;
 
-    }
+            parseError = argumentCounter == argc || parseNumberAgainstList(argument, validAutosaveDurations, NUMBER_OF_VALID_AUTOSAVE_DURATIONS, &duration) == false;
 
-    return NULL;
+            autosaveDuration = duration;
 
-}
+        } else if (parseArgument("MONITOR", argument)) {
+            
+            monitorEnabled = true;
 
-/* Interrupt handler */
+        } else if (parseArgument("HETERODYNE", argument)) { 
 
-void Signal_handleSignal(void) {
+            argumentCounter += 1;
 
-    success = false;
+            monitorMode = MONITOR_HETERODYNE;
 
-}
+            argument = argv[argumentCounter];
 
-/* Argument parsing functions */
+            parseError = argumentCounter == argc || parseNumber(argument, &heterodyneFrequency) == false;
 
-static bool parseArgument(char *pattern, char *text) {
+        } else if (parseArgument("CONTROL", argument)) {
 
-    static char buffer[ARGUMENT_BUFFER_SIZE];
+            argumentCounter += 1;
 
-    for (int32_t i = 0; i < ARGUMENT_BUFFER_SIZE; i += 1) {
+            argument = argv[argumentCounter];
 
-        buffer[i] = toupper(text[i]);
+            parseError = argumentCounter == argc || strlen(argument) >= CONTROL_PATH_SIZE;
 
-        if (buffer[i] == 0) break;
+            if (parseError == false) strncpy(controlPath, argument, CONTROL_PATH_SIZE);
 
-    }
+        } else if (parseArgument("METRICS", argument)) {
 
-    return strncmp(pattern, buffer, ARGUMENT_BUFFER_SIZE) == 0;
+            argumentCounter += 1;
 
-}
+            argument = argv[argumentCounter];
 
-static bool parseNumber(char *text, int32_t *number) {
+            parseError = argumentCounter == argc || strlen(argument) >= METRICS_PATH_SIZE;
 
-    for (int32_t i = 0; i < ARGUMENT_BUFFER_SIZE; i += 1) {
+            if (parseError == false) strncpy(metricsPath, argument, METRICS_PATH_SIZE);
 
-        char character = text[i];
+        } else if (parseArgument("STREAM", argument)) {
 
-        if (character == 0) break;
+            argumentCounter += 1;
 
-        if (character < '0' || character > '9') return false;
+            argument = argv[argumentCounter];
 
-    }
+            parseError = argumentCounter == argc || strlen(argument) >= STREAM_PATH_SIZE;
 
-    if (number != NULL) *number = atoi(text);
+            if (parseError == false) strncpy(streamPath, argument, STREAM_PATH_SIZE);
 
-    return true;
+        } else if (parseArgument("LEQ", argument)) {
 
-}
+            argumentCounter += 1;
 
-static bool parseNumberAgainstList(char *text, int32_t *validNumbers, int32_t length, int32_t *number) {
+            argument = argv[argumentCounter];
 
-    int32_t value;
+            parseError = argumentCounter == argc || strlen(argument) >= SOUND_LEVEL_PATH_SIZE;
 
-    bool isNumber = parseNumber(text, &value);
+            if (parseError == false) strncpy(soundLevelPath, argument, SOUND_LEVEL_PATH_SIZE);
 
-    if (isNumber == false) return false;
+        } else if (parseArgument("SHAREDMEMORY", argument)) {
 
-    for (int32_t i = 0; i < length; i += 1) {
+            argumentCounter += 1;
 
-        if (value == validNumbers[i]) {
+            argument = argv[argumentCounter];
 
-            *number = value;
+            parseError = argumentCounter == argc || strlen(argument) >= SHARED_MEMORY_NAME_SIZE;
 
-            return true;
+            if (parseError == false) strncpy(sharedMemoryName, argument, SHARED_MEMORY_NAME_SIZE);
 
-        }
+        } else if (parseArgument("PERSISTENTBUFFER", argument)) {
 
-    }
+            argumentCounter += 1;
 
-    return false;
+            argument = argv[argumentCounter];
 
-}
+            parseError = argumentCounter == argc || strlen(argument) >= PERSISTENT_RING_PATH_SIZE;
 
-/* Exported functions */
+            if (parseError == false) strncpy(persistentRingPath, argument, PERSISTENT_RING_PATH_SIZE);
 
-int main(int argc, char **argv) {
+        } else if (parseArgument("TCPSERVER", argument) || parseArgument("UDPSERVER", argument)) {
 
-    success = true;
+            networkProtocol = parseArgument("TCPSERVER", argument) ? NT_TCP : NT_UDP;
 
-    bool monitorEnabled = false;
+            argumentCounter += 1;
 
-    puts("AudioMoth-Live 1.0.0");
+            argument = argv[argumentCounter];
 
-    /* Set default file destination */
+            parseError = argumentCounter == argc || parseNumber(argument, &networkPort) == false;
 
-    strncpy(fileDestination, ".", FILE_DESTINATION_SIZE);
+            parseError = parseError || networkPort < MINIMUM_NETWORK_PORT || networkPort > MAXIMUM_NETWORK_PORT;
 
-    /* Parse arguments */
+        } else if (parseArgument("BIND", argument)) {
 
-    bool parseError = false;
+            argumentCounter += 1;
 
-    int32_t argumentCounter = 1;
+            argument = argv[argumentCounter];
 
-    int32_t heterodyneFrequency = 0;
+            parseError = argumentCounter == argc || strlen(argument) >= NETWORK_ADDRESS_SIZE;
 
-    int32_t possibleFileDestinationCount = 0;
+            if (parseError == false) strncpy(networkBindAddress, argument, NETWORK_ADDRESS_SIZE);
 
-    while (argumentCounter < argc) {
+        } else if (parseArgument("RETENTION", argument)) {
 
-        char *argument = argv[argumentCounter];
+            retentionEnabled = true;
 
-        if (argumentCounter == possibleFileDestinationCount) {
+            parseError = argumentCounter + 3 >= argc;
 
-            bool exists = Directory_exists(argument);
+            parseError = parseError || parseNumber(argv[argumentCounter + 1], &retentionMaximumSize) == false;
 
-            if (exists) {
+            parseError = parseError || parseNumber(argv[argumentCounter + 2], &retentionMaximumAge) == false;
 
-                strncpy(fileDestination, argument, FILE_DESTINATION_SIZE);
+            parseError = parseError || parseNumber(argv[argumentCounter + 3], &retentionMinimumFreeSpace) == false;
 
-                argumentCounter += 1;
+            argumentCounter += 3;
 
-                continue;
+        } else if (parseArgument("ARCHIVE", argument)) {
 
-            }
+            argumentCounter += 1;
 
-        }
+            argument = argv[argumentCounter];
 
-        if (parseArgument("HIGHSAMPLERATE", argument) || parseArgument("HSR", argument)) {
-            
-            maximumDefaultSampleRate = MAXIMUM_SAMPLE_RATE;
+            parseError = argumentCounter == argc || Directory_exists(argument) == false;
 
-        } else if (parseArgument("UTC", argument)) {
-            
-            useLocalTime = false;
+            if (parseError == false) strncpy(archiveDestination, argument, FILE_DESTINATION_SIZE - 1);
 
-        } else if (parseArgument("AUTOSAVE", argument)) {
+        } else if (parseArgument("FREQUENCYDIVISION", argument) || parseArgument("FD", argument)) {
 
             argumentCounter += 1;
 
-            argument = argv[argumentCounter];
+            monitorMode = MONITOR_FREQUENCY_DIVISION;
 
-            possibleFileDestinationCount = argumentCounter + 1;
-        
-            parseError = argumentCounter == argc || parseNumberAgainstList(argument, validAutosaveDurations, NUMBER_OF_VALID_AUTOSAVE_DURATIONS, &autosaveDuration) == false;
+            argument = argv[argumentCounter];
 
-        } else if (parseArgument("MONITOR", argument)) {
-            
-            monitorEnabled = true;
+            parseError = argumentCounter == argc || parseNumber(argument, &frequencyDivisionRatio) == false;
 
-        } else if (parseArgument("HETERODYNE", argument)) { 
+        } else if (parseArgument("TIMEEXPANSION", argument) || parseArgument("TE", argument)) {
 
             argumentCounter += 1;
 
-            heterodyneEnabled = true;
+            monitorMode = MONITOR_TIME_EXPANSION;
 
             argument = argv[argumentCounter];
 
-            parseError = argumentCounter == argc || parseNumber(argument, &heterodyneFrequency) == false;
+            parseError = argumentCounter == argc || parseNumber(argument, &timeExpansionDuration) == false;
 
         } else {
 
@@ -1223,15 +2935,29 @@ int main(int argc, char **argv) {
 
     }
     
-    if (monitorEnabled == false && heterodyneEnabled == false && autosaveDuration == 0) return OKAY_RESPONSE;
+    if (monitorEnabled == false && monitorMode == MONITOR_NORMAL && autosaveDuration == 0 && controlPath[0] == 0 && streamPath[0] == 0 && soundLevelPath[0] == 0 && sharedMemoryName[0] == 0 && networkPort == 0) return OKAY_RESPONSE;
 
     /* Initialise timers */
 
     ma_timer_init(&timer);
 
-    /* Initialise the contexts */
+    /* Initialise the contexts with exclusive capture on Linux going straight to ALSA rather than through a sound server */
+
+    #if defined(__linux__)
+
+        ma_backend captureBackends[] = {ma_backend_alsa};
+
+        int32_t numberOfCaptureBackends = exclusiveModeEnabled ? 1 : 0;
+
+    #else
 
-    ma_result result = ma_context_init(NULL, 0, NULL, &deviceCheckContext);
+        ma_backend *captureBackends = NULL;
+
+        int32_t numberOfCaptureBackends = 0;
+
+    #endif
+
+    ma_result result = ma_context_init(numberOfCaptureBackends > 0 ? captureBackends : NULL, numberOfCaptureBackends, NULL, &deviceCheckContext);
 
     if (result != MA_SUCCESS) {
         
@@ -1251,9 +2977,21 @@ int main(int argc, char **argv) {
 
     }
 
+    /* Start the logger before any worker thread */
+
+    bool initialised = Logger_initialise(logFormat);
+
+    if (initialised == false) {
+
+        puts("[ERROR] Could not start logger.");
+
+        success = false;
+
+    }
+
     /* Initialise autosave queue */
 
-    bool initialised = Autosave_initialise(AUTOSAVE_EVENT_QUEUE_SIZE);
+    initialised = Autosave_initialise(AUTOSAVE_EVENT_QUEUE_SIZE);
 
     if (initialised == false) {
         
@@ -1263,11 +3001,81 @@ int main(int argc, char **argv) {
 
     }
 
+    /* Repair the last file if the previous run was interrupted */
+
+    if (autosaveDuration > 0) recoverAutosaveFile();
+
+    /* Initialise retention index */
+
+    if (retentionEnabled) {
+
+        initialised = Retention_initialise(fileDestination, (int64_t)retentionMaximumSize * BYTES_IN_MEGABYTE, (int64_t)retentionMaximumAge * SECONDS_IN_HOUR, (int64_t)retentionMinimumFreeSpace * BYTES_IN_MEGABYTE, archiveDestination[0] == 0 ? NULL : archiveDestination);
+
+        if (initialised == false) {
+
+            puts("[ERROR] Could not initialise retention index.");
+
+            success = false;
+
+        } else if (Retention_enforce(time(NULL)) == false) {
+
+            Logger_log(LG_ERROR, LG_RETENTION, "Could not remove old WAV file");
+
+        }
+
+    }
+
+    /* Initialise metrics export */
+
+    if (metricsPath[0] != 0 && Metrics_initialise(metricsPath) == false) {
+
+        puts("[ERROR] Could not write metrics file.");
+
+        success = false;
+
+    }
+
+    /* Size the buffers by total samples so that each extra channel shortens the buffer rather than adding to its memory */
+
+    audioBufferFrames = AUDIO_BUFFER_SIZE / numberOfChannels;
+
+    if ((int64_t)requestedSampleRate * MINIMUM_BUFFER_DURATION > audioBufferFrames) {
+
+        puts("[ERROR] Could not buffer this many channels at the requested sample rate.");
+
+        success = false;
+
+    }
+
+    /* The float pipeline keeps its float buffer as the only copy of the audio unless shared memory or the persistent buffer need an int16 copy */
+
+    bool int16BufferNeeded = floatPipelineEnabled == false || sharedMemoryName[0] != 0 || persistentRingPath[0] != 0;
+
     /* Initialise the audio buffer */
 
-    audioBuffer = (int16_t*)malloc(AUDIO_BUFFER_SIZE * NUMBER_OF_BYTES_IN_SAMPLE);
+    PR_recovery_t recovery = {0};
 
-    if (audioBuffer == NULL) {
+    if (sharedMemoryName[0] != 0 && persistentRingPath[0] != 0) {
+
+        puts("[ERROR] Could not use shared memory and persistent buffer together.");
+
+        success = false;
+
+    } else if (sharedMemoryName[0] != 0) {
+
+        audioBuffer = SharedRing_initialise(sharedMemoryName, audioBufferFrames);
+
+    } else if (persistentRingPath[0] != 0) {
+
+        audioBuffer = PersistentRing_initialise(persistentRingPath, audioBufferFrames, &recovery);
+
+    } else if (int16BufferNeeded) {
+
+        audioBuffer = (int16_t*)calloc(audioBufferFrames, NUMBER_OF_BYTES_IN_SAMPLE);
+
+    }
+
+    if (int16BufferNeeded && audioBuffer == NULL) {
 
         puts("[ERROR] Could not initialise audio buffer.");
 
@@ -1275,12 +3083,54 @@ int main(int argc, char **argv) {
 
     }
 
+    /* Save samples left in the persistent buffer by an interrupted run before capture overwrites them */
+
+    WavFile_setSampleFormats(WAV_INT16, wavFileFormat, 1);
+
+    if (audioBuffer != NULL) saveRecoveredSamples(&recovery);
+
+    /* Keep every channel in an interleaved float buffer for wider WAV files */
+
+    if (floatPipelineEnabled) {
+
+        floatAudioBuffer = (float*)calloc((size_t)audioBufferFrames * numberOfChannels, sizeof(float));
+
+        if (floatAudioBuffer == NULL) {
+
+            puts("[ERROR] Could not initialise float audio buffer.");
+
+            success = false;
+
+        }
+
+    }
+
+    /* Keep an interleaved copy of the buffer for multi-channel 16-bit WAV files */
+
+    if (floatPipelineEnabled == false && numberOfChannels > 1) {
+
+        channelAudioBuffer = (int16_t*)calloc((size_t)audioBufferFrames * numberOfChannels, NUMBER_OF_BYTES_IN_SAMPLE);
+
+        if (channelAudioBuffer == NULL) {
+
+            puts("[ERROR] Could not initialise multi-channel audio buffer.");
+
+            success = false;
+
+        }
+
+    }
+
+    WavFile_setSampleFormats(floatPipelineEnabled ? WAV_FLOAT32 : WAV_INT16, wavFileFormat, numberOfChannels);
+
     /* Initialise mutexes */
 
     pthread_mutex_init(&autosaveMutex, NULL);
 
     pthread_mutex_init(&stopStartMutex, NULL);
 
+    pthread_mutex_init(&playbackMutex, NULL);
+
     pthread_mutex_init(&backgroundMutex, NULL);
 
     pthread_mutex_init(&audioBufferMutex, NULL);
@@ -1353,7 +3203,7 @@ int main(int argc, char **argv) {
 
     /* Check if heterodyne is possible */
 
-    if (heterodyneEnabled) {
+    if (monitorMode == MONITOR_HETERODYNE) {
 
         if (heterodyneFrequency < MINIMUM_HETERODYNE_FREQUENCY || heterodyneFrequency > currentSampleRate / 2) {
 
@@ -1369,11 +3219,83 @@ int main(int argc, char **argv) {
 
     }
 
-    /* Start autosave, monitor and heterodyne */
+    /* Check if frequency division is possible */
+
+    if (monitorMode == MONITOR_FREQUENCY_DIVISION) {
+
+        if (frequencyDivisionRatio < MINIMUM_FREQUENCY_DIVISION_RATIO || frequencyDivisionRatio > MAXIMUM_FREQUENCY_DIVISION_RATIO) {
+
+            puts("[ERROR] Could not set requested frequency division ratio.");
+
+            return ERROR_RESPONSE;
+
+        } else {
+
+            FrequencyDivision_initialise(currentSampleRate, frequencyDivisionRatio);
+
+        }
+
+    }
+
+    /* Check if time expansion is possible */
+
+    if (monitorMode == MONITOR_TIME_EXPANSION) {
+
+        if (timeExpansionDuration < MINIMUM_TIME_EXPANSION_DURATION || timeExpansionDuration > MAXIMUM_TIME_EXPANSION_DURATION) {
+
+            puts("[ERROR] Could not set requested time expansion duration.");
+
+            return ERROR_RESPONSE;
+
+        }
+
+    }
+
+    /* Start autosave, monitor, heterodyne, frequency division and time expansion */
 
     if (autosaveDuration > 0) addAutosaveEvent(AS_START);
 
-    if (monitorEnabled || heterodyneEnabled) pthread_create(&startPlaybackThread, NULL, startPlaybackThreadBody, NULL);
+    if (monitorEnabled || monitorMode != MONITOR_NORMAL) pthread_create(&startPlaybackThread, NULL, startPlaybackThreadBody, NULL);
+
+    /* Open control socket */
+
+    if (controlPath[0] != 0 && Control_initialise(controlPath, handleControlCommand) == false) {
+
+        puts("[ERROR] Could not open control socket.");
+
+        return ERROR_RESPONSE;
+
+    }
+
+    /* Start stream output */
+
+    if (streamPath[0] != 0 && Stream_initialise(streamPath) == false) {
+
+        puts("[ERROR] Could not open stream output.");
+
+        return ERROR_RESPONSE;
+
+    }
+
+    /* Start sound level log */
+
+    if (soundLevelPath[0] != 0 && SoundLevel_initialise(soundLevelPath) == false) {
+
+        puts("[ERROR] Could not open sound level log.");
+
+        return ERROR_RESPONSE;
+
+    }
+
+    /* Start network server */
+
+    if (networkPort > 0 && Network_initialise(networkProtocol, networkPort, networkBindAddress[0] == 0 ? NULL : networkBindAddress) == false) {
+
+        puts("[ERROR] Could not start network server.");
+
+        return ERROR_RESPONSE;
+
+    }
 
     /* Register signal handler */
 
@@ -1387,6 +3309,10 @@ int main(int argc, char **argv) {
 
         usleep(MICROSECONDS_IN_SECOND / CALLBACKS_PER_SECOND);
 
+        /* Update the level meter */
+
+        if (meterEnabled) showLevelMeter();
+
         /* Get the current audio time */
 
         pthread_mutex_lock(&audioBufferMutex);
@@ -1415,6 +3341,10 @@ int main(int argc, char **argv) {
 
         pthread_mutex_lock(&backgroundMutex);
 
+        bool restartRequested = backgroundRestartRequested;
+
+        backgroundRestartRequested = false;
+
         if (backgroundDeviceCheckTime - timeDeviceStarted > DEVICE_CHANGE_INTERVAL) {
 
             if (backgroundDeviceCheckFoundAudioMoth == true && usingAudioMoth == false) deviceChanged = true;
@@ -1431,13 +3361,17 @@ int main(int argc, char **argv) {
 
         /* Show warning if old AudioMoth found */
 
-        if (showOldAudioMothFoundWarning) puts("[WARNING] The AudioMoth USB Microphone firmware running on your AudioMoth device is out of date.");
+        if (showOldAudioMothFoundWarning) Logger_log(LG_WARNING, LG_CAPTURE, "The AudioMoth USB Microphone firmware running on your AudioMoth device is out of date.");
 
         /* Continue if the device has not changed */
 
-        if (deviceChanged == false && timeMismatch == false) continue;
+        if (deviceChanged == false && timeMismatch == false && restartRequested == false) continue;
 
-        if (timeMismatch) puts("[WARNING] Restarting due to time mismatch.");
+        if (timeMismatch) Logger_log(LG_WARNING, LG_CAPTURE, "Restarting due to time mismatch.");
+
+        if (timeMismatch) Metrics_add(MT_RESTARTS_TIME_MISMATCH, 1);
+
+        if (deviceChanged) Metrics_add(MT_RESTARTS_DEVICE_CHANGE, 1);
 
         /* Reset the stopped flag */
 
@@ -1467,7 +3401,7 @@ int main(int argc, char **argv) {
 
             if (currentTime - startTime > DEVICE_STOP_START_TIMEOUT) {
 
-                if (IS_WINDOWS == false) puts("[ERROR] Timed out waiting for device to stop.");
+                if (IS_WINDOWS == false) Logger_log(LG_ERROR, LG_CAPTURE, "Timed out waiting for device to stop.");
 
                 break;
 
@@ -1503,12 +3437,18 @@ int main(int argc, char **argv) {
 
         if (startedMicrophone) {
 
-            printf("Connected to %s with sample rate of %dkHz.\n", inputDeviceCommentName, currentSampleRate / HERTZ_IN_KILOHERTZ);
+            Logger_log(LG_INFO, LG_CAPTURE, "Connected to %s with sample rate of %dkHz.", inputDeviceCommentName, currentSampleRate / HERTZ_IN_KILOHERTZ);
 
         }
 
         timeDeviceStarted = ma_timer_get_time_in_seconds(&timer);
 
+        /* Update monitor for the new sample rate */
+
+        if (monitorMode == MONITOR_HETERODYNE) atomic_store_explicit(&heterodyneRequest, heterodyneFrequency, memory_order_release);
+
+        if (monitorMode == MONITOR_FREQUENCY_DIVISION) atomic_store_explicit(&frequencyDivisionRequest, true, memory_order_release);
+
         /* Wait for device to start */
 
         bool threadStarted = false;
@@ -1521,7 +3461,7 @@ int main(int argc, char **argv) {
 
             if (currentTime - startTime > DEVICE_STOP_START_TIMEOUT) {
 
-                puts("[ERROR] Timed out waiting for device to start.");
+                Logger_log(LG_ERROR, LG_CAPTURE, "Timed out waiting for device to start.");
 
                 break;
 
@@ -1543,9 +3483,27 @@ int main(int argc, char **argv) {
 
     if (success == false && IS_WINDOWS == false) puts("");
 
+    /* Close control socket */
+
+    Control_close();
+
+    /* Write the last sound levels */
+
+    SoundLevel_close();
+
+    /* Remove shared memory name */
+
+    SharedRing_close();
+
     /* Exit if not using autosave */
 
-    if (autosaveDuration == 0) return OKAY_RESPONSE;
+    if (autosaveDuration == 0) {
+
+        Logger_close();
+
+        return OKAY_RESPONSE;
+
+    }
 
     /* Set shutdown flag */
 
@@ -1583,7 +3541,9 @@ int main(int argc, char **argv) {
 
     }
 
-    /* Exit */
+    /* Flush the log and exit */
+
+    Logger_close();
 
     return OKAY_RESPONSE;
 
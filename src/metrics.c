@@ -0,0 +1,144 @@
+/****************************************************************************
+ * metrics.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "macros.h"
+#include "threads.h"
+#include "metrics.h"
+#include "xatomic.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+/* Export constants */
+
+#define METRICS_PATH_SIZE               1024
+#define METRICS_EXPORT_INTERVAL         1000000
+
+#define TEMPORARY_SUFFIX                ".tmp"
+
+/* Metric descriptions */
+
+typedef struct {
+    char *name;
+    char *type;
+    char *help;
+    double scale;
+} MT_description_t;
+
+static MT_description_t descriptions[MT_NUMBER_OF_METRICS] = {
+    [MT_SAMPLES_CAPTURED] = {"audiomoth_live_samples_captured_total", "counter", "Samples written to the audio buffer.", 1.0},
+    [MT_SAMPLES_WRITTEN] = {"audiomoth_live_samples_written_total", "counter", "Samples written to WAV files.", 1.0},
+    [MT_FILES_WRITTEN] = {"audiomoth_live_file_writes_total", "counter", "WAV file writes and appends.", 1.0},
+    [MT_RING_FILL] = {"audiomoth_live_ring_fill_ratio", "gauge", "Fraction of the audio buffer waiting to be written.", METRICS_RATIO_SCALE},
+    [MT_WRITER_LAG] = {"audiomoth_live_writer_lag_samples", "gauge", "Samples captured but not yet written.", 1.0},
+    [MT_FILE_WRITE_LATENCY] = {"audiomoth_live_file_write_latency_seconds", "gauge", "Duration of the most recent WAV file write.", 1000000.0},
+    [MT_RESTARTS_TIME_MISMATCH] = {"audiomoth_live_restarts_time_mismatch_total", "counter", "Device restarts caused by a time mismatch.", 1.0},
+    [MT_RESTARTS_DEVICE_CHANGE] = {"audiomoth_live_restarts_device_change_total", "counter", "Device restarts caused by a device change.", 1.0},
+    [MT_ENUMERATION_TIME] = {"audiomoth_live_enumeration_seconds", "gauge", "Duration of the most recent device enumeration.", 1000000.0},
+    [MT_PLAYBACK_STARVATIONS] = {"audiomoth_live_playback_starvations_total", "counter", "Playback callbacks with too few samples available.", 1.0},
+    [MT_STREAM_DROPPED_SAMPLES] = {"audiomoth_live_stream_dropped_samples_total", "counter", "Samples dropped because the stream reader was too slow.", 1.0},
+    [MT_NETWORK_DROPPED_SAMPLES] = {"audiomoth_live_network_dropped_samples_total", "counter", "Samples skipped because a network subscriber was too slow.", 1.0},
+    [MT_PEAK_LEVEL] = {"audiomoth_live_peak_level_dbfs", "gauge", "Peak level of the most recent 100ms capture block.", METRICS_DECIBEL_SCALE},
+    [MT_RMS_LEVEL] = {"audiomoth_live_rms_level_dbfs", "gauge", "RMS level of the most recent 100ms capture block.", METRICS_DECIBEL_SCALE},
+    [MT_CLIPPED_SAMPLES] = {"audiomoth_live_clipped_samples_total", "counter", "Captured samples at the limit of the input range.", 1.0}
+};
+
+/* Metric values */
+
+static atomic_int_least64_t values[MT_NUMBER_OF_METRICS];
+
+/* Export variables */
+
+static pthread_t metricsThread;
+
+static char metricsPath[METRICS_PATH_SIZE];
+
+static char temporaryPath[METRICS_PATH_SIZE + sizeof(TEMPORARY_SUFFIX)];
+
+/* Private functions */
+
+static bool writeMetricsFile(void) {
+
+    FILE *outputFile = fopen(temporaryPath, "w");
+
+    if (outputFile == NULL) return false;
+
+    for (int32_t i = 0; i < MT_NUMBER_OF_METRICS; i += 1) {
+
+        int64_t value = atomic_load_explicit(&values[i], memory_order_relaxed);
+
+        fprintf(outputFile, "# HELP %s %s\n# TYPE %s %s\n", descriptions[i].name, descriptions[i].help, descriptions[i].name, descriptions[i].type);
+
+        if (descriptions[i].scale == 1.0) {
+
+            fprintf(outputFile, "%s %lld\n", descriptions[i].name, (long long)value);
+
+        } else {
+
+            fprintf(outputFile, "%s %.6f\n", descriptions[i].name, (double)value / descriptions[i].scale);
+
+        }
+
+    }
+
+    if (fclose(outputFile) != 0) return false;
+
+    /* Rename over the previous file so collectors never see a partial file */
+
+    if (IS_WINDOWS) remove(metricsPath);
+
+    return rename(temporaryPath, metricsPath) == 0;
+
+}
+
+static void *metricsThreadBody(void *ptr) {
+
+    while (true) {
+
+        writeMetricsFile();
+
+        usleep(METRICS_EXPORT_INTERVAL);
+
+    }
+
+    return NULL;
+
+}
+
+/* Public functions */
+
+void Metrics_add(MT_metric_t metric, int64_t value) {
+
+    atomic_fetch_add_explicit(&values[metric], value, memory_order_relaxed);
+
+}
+
+void Metrics_set(MT_metric_t metric, int64_t value) {
+
+    atomic_store_explicit(&values[metric], value, memory_order_relaxed);
+
+}
+
+bool Metrics_initialise(const char *path) {
+
+    if (strlen(path) >= METRICS_PATH_SIZE) return false;
+
+    strncpy(metricsPath, path, METRICS_PATH_SIZE - 1);
+
+    sprintf(temporaryPath, "%s%s", metricsPath, TEMPORARY_SUFFIX);
+
+    if (writeMetricsFile() == false) return false;
+
+    return pthread_create(&metricsThread, NULL, metricsThreadBody, NULL) == 0;
+
+}
@@ -0,0 +1,575 @@
+/****************************************************************************
+ * network.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xtime.h"
+#include "macros.h"
+#include "network.h"
+#include "capture.h"
+#include "metrics.h"
+#include "threads.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    bool Network_initialise(NT_protocol_t protocol, int32_t port, const char *bindAddress) {
+
+        return false;
+
+    }
+
+#else
+
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/socket.h>
+    #include <arpa/inet.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+
+    #ifndef MSG_NOSIGNAL
+        #define MSG_NOSIGNAL 0
+    #endif
+
+    /* Server constants */
+
+    #define MAXIMUM_SUBSCRIBERS             8
+    #define SERVER_POLL_INTERVAL            10000
+    #define SUBSCRIBER_TIMEOUT              30
+    #define CONTROL_MESSAGE_SIZE            64
+    #define MAXIMUM_CHALLENGES              16
+    #define NONCE_STRING_SIZE               17
+
+    #define SUBSCRIBE_MESSAGE               "SUBSCRIBE "
+    #define CHALLENGE_MESSAGE               "NONCE "
+    #define UNSUBSCRIBE_MESSAGE             "STOP"
+
+    #define RANDOM_DEVICE                   "/dev/urandom"
+
+    #define MILLISECONDS_IN_SECOND          1000
+
+    /* Packet constants following RFC 3550 with an extension carrying the sample rate and UTC time */
+
+    #define RTP_VERSION_WITH_EXTENSION      0x90
+    #define RTP_PAYLOAD_TYPE                96
+    #define RTP_EXTENSION_PROFILE           0x414D
+    #define RTP_EXTENSION_LENGTH            3
+
+    #define RTP_HEADER_SIZE                 12
+    #define RTP_EXTENSION_SIZE              (4 + 4 * RTP_EXTENSION_LENGTH)
+    #define TCP_FRAMING_SIZE                2
+
+    #define PACKET_SAMPLES                  640
+    #define PACKET_BUFFER_SIZE              (TCP_FRAMING_SIZE + RTP_HEADER_SIZE + RTP_EXTENSION_SIZE + PACKET_SAMPLES * 2)
+
+    /* Subscriber structure */
+
+    typedef struct {
+        int32_t sampleRate;
+        int64_t startTime;
+        int64_t startCount;
+    } NT_segment_t;
+
+    typedef struct {
+        bool active;
+        int socket;
+        struct sockaddr_in address;
+        uint64_t nonce;
+        time_t lastSeen;
+        int64_t readCount;
+        uint16_t sequence;
+        NT_segment_t segment;
+        int32_t pendingOffset;
+        int32_t pendingLength;
+        uint8_t packet[PACKET_BUFFER_SIZE];
+    } NT_subscriber_t;
+
+    typedef struct {
+        struct sockaddr_in address;
+        uint64_t nonce;
+        time_t issued;
+    } NT_challenge_t;
+
+    /* Server variables */
+
+    static int serverSocket = -1;
+
+    static NT_protocol_t serverProtocol;
+
+    static uint32_t synchronisationSource;
+
+    static pthread_t networkThread;
+
+    static NT_subscriber_t subscribers[MAXIMUM_SUBSCRIBERS];
+
+    static NT_challenge_t challenges[MAXIMUM_CHALLENGES];
+
+    static int randomFile = -1;
+
+    /* Private functions to write big endian fields */
+
+    static inline uint8_t *writeUint16(uint8_t *buffer, uint16_t value) {
+
+        buffer[0] = value >> 8;
+        buffer[1] = value;
+
+        return buffer + 2;
+
+    }
+
+    static inline uint8_t *writeUint32(uint8_t *buffer, uint32_t value) {
+
+        buffer = writeUint16(buffer, value >> 16);
+
+        return writeUint16(buffer, value);
+
+    }
+
+    /* Private functions to manage subscribers */
+
+    static NT_subscriber_t *addSubscriber(int socket, struct sockaddr_in *address, CP_state_t *state) {
+
+        for (int32_t i = 0; i < MAXIMUM_SUBSCRIBERS; i += 1) {
+
+            NT_subscriber_t *subscriber = subscribers + i;
+
+            if (subscriber->active) continue;
+
+            memset(subscriber, 0, sizeof(NT_subscriber_t));
+
+            subscriber->active = true;
+
+            subscriber->socket = socket;
+
+            if (address != NULL) memcpy(&subscriber->address, address, sizeof(struct sockaddr_in));
+
+            subscriber->lastSeen = time(NULL);
+
+            subscriber->readCount = state->sampleCount;
+
+            subscriber->segment.sampleRate = state->sampleRate;
+
+            subscriber->segment.startTime = state->startTime;
+
+            subscriber->segment.startCount = state->startCount;
+
+            return subscriber;
+
+        }
+
+        return NULL;
+
+    }
+
+    static void removeSubscriber(NT_subscriber_t *subscriber) {
+
+        if (serverProtocol == NT_TCP) close(subscriber->socket);
+
+        subscriber->active = false;
+
+    }
+
+    /* Private functions to issue subscription challenges to datagram senders */
+
+    static bool isSameAddress(struct sockaddr_in *address, struct sockaddr_in *otherAddress) {
+
+        return address->sin_addr.s_addr == otherAddress->sin_addr.s_addr && address->sin_port == otherAddress->sin_port;
+
+    }
+
+    static NT_challenge_t *findChallenge(struct sockaddr_in *address) {
+
+        for (int32_t i = 0; i < MAXIMUM_CHALLENGES; i += 1) {
+
+            if (challenges[i].nonce != 0 && isSameAddress(&challenges[i].address, address)) return challenges + i;
+
+        }
+
+        return NULL;
+
+    }
+
+    static void sendChallenge(struct sockaddr_in *address) {
+
+        static char message[CONTROL_MESSAGE_SIZE];
+
+        /* Reuse the sender's slot or replace the oldest challenge */
+
+        NT_challenge_t *challenge = findChallenge(address);
+
+        for (int32_t i = 0; i < MAXIMUM_CHALLENGES && challenge == NULL; i += 1) {
+
+            if (challenges[i].nonce == 0) challenge = challenges + i;
+
+        }
+
+        if (challenge == NULL) {
+
+            challenge = challenges;
+
+            for (int32_t i = 1; i < MAXIMUM_CHALLENGES; i += 1) {
+
+                if (challenges[i].issued < challenge->issued) challenge = challenges + i;
+
+            }
+
+        }
+
+        uint64_t nonce = 0;
+
+        if (read(randomFile, &nonce, sizeof(uint64_t)) != (ssize_t)sizeof(uint64_t) || nonce == 0) return;
+
+        memcpy(&challenge->address, address, sizeof(struct sockaddr_in));
+
+        challenge->nonce = nonce;
+
+        challenge->issued = time(NULL);
+
+        int32_t length = snprintf(message, CONTROL_MESSAGE_SIZE, "%s%016llx", CHALLENGE_MESSAGE, (unsigned long long)nonce);
+
+        sendto(serverSocket, message, length, MSG_NOSIGNAL, (struct sockaddr*)address, sizeof(struct sockaddr_in));
+
+    }
+
+    static void acceptSubscribers(CP_state_t *state) {
+
+        if (serverProtocol == NT_TCP) {
+
+            int clientSocket;
+
+            while ((clientSocket = accept(serverSocket, NULL, NULL)) >= 0) {
+
+                int option = 1;
+
+                setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &option, sizeof(option));
+
+                #ifdef SO_NOSIGPIPE
+
+                    setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &option, sizeof(option));
+
+                #endif
+
+                fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL) | O_NONBLOCK);
+
+                if (addSubscriber(clientSocket, NULL, state) == NULL) close(clientSocket);
+
+            }
+
+            return;
+
+        }
+
+        /* A datagram sender only subscribes by echoing a nonce sent to its address, so a spoofed source cannot start a stream */
+
+        static char message[CONTROL_MESSAGE_SIZE + 1];
+
+        struct sockaddr_in address;
+
+        socklen_t addressLength = sizeof(struct sockaddr_in);
+
+        ssize_t length;
+
+        while ((length = recvfrom(serverSocket, message, CONTROL_MESSAGE_SIZE, 0, (struct sockaddr*)&address, &addressLength)) >= 0) {
+
+            message[length] = 0;
+
+            addressLength = sizeof(struct sockaddr_in);
+
+            NT_subscriber_t *subscriber = NULL;
+
+            for (int32_t i = 0; i < MAXIMUM_SUBSCRIBERS && subscriber == NULL; i += 1) {
+
+                if (subscribers[i].active && isSameAddress(&subscribers[i].address, &address)) subscriber = subscribers + i;
+
+            }
+
+            if (strncmp(message, UNSUBSCRIBE_MESSAGE, strlen(UNSUBSCRIBE_MESSAGE)) == 0) {
+
+                if (subscriber != NULL) removeSubscriber(subscriber);
+
+                continue;
+
+            }
+
+            if (strncmp(message, SUBSCRIBE_MESSAGE, strlen(SUBSCRIBE_MESSAGE)) != 0) continue;
+
+            uint64_t nonce = strtoull(message + strlen(SUBSCRIBE_MESSAGE), NULL, 16);
+
+            /* Refresh an existing subscriber which echoes its nonce */
+
+            if (subscriber != NULL) {
+
+                if (nonce == subscriber->nonce) subscriber->lastSeen = time(NULL);
+
+                continue;
+
+            }
+
+            /* Subscribe a sender which echoes an outstanding challenge */
+
+            NT_challenge_t *challenge = findChallenge(&address);
+
+            if (challenge != NULL && nonce != 0 && nonce == challenge->nonce && time(NULL) - challenge->issued <= SUBSCRIBER_TIMEOUT) {
+
+                subscriber = addSubscriber(serverSocket, &address, state);
+
+                if (subscriber != NULL) subscriber->nonce = nonce;
+
+                memset(challenge, 0, sizeof(NT_challenge_t));
+
+                continue;
+
+            }
+
+            /* Otherwise send a challenge no longer than the request so the server cannot amplify traffic */
+
+            if ((size_t)length >= strlen(CHALLENGE_MESSAGE) + NONCE_STRING_SIZE - 1) sendChallenge(&address);
+
+        }
+
+    }
+
+    /* Private functions to build and send packets */
+
+    static int32_t buildPacket(NT_subscriber_t *subscriber, CP_state_t *state, int32_t numberOfSamples) {
+
+        uint8_t *buffer = subscriber->packet;
+
+        NT_segment_t *segment = &subscriber->segment;
+
+        int64_t timestamp = segment->startTime + ROUNDED_DIV((subscriber->readCount - segment->startCount) * MILLISECONDS_IN_SECOND, segment->sampleRate);
+
+        int32_t packetLength = RTP_HEADER_SIZE + RTP_EXTENSION_SIZE + numberOfSamples * 2;
+
+        if (serverProtocol == NT_TCP) buffer = writeUint16(buffer, packetLength);
+
+        /* Fixed RTP header with the sample count as the media timestamp */
+
+        *buffer++ = RTP_VERSION_WITH_EXTENSION;
+        *buffer++ = RTP_PAYLOAD_TYPE;
+
+        buffer = writeUint16(buffer, subscriber->sequence);
+        buffer = writeUint32(buffer, (uint32_t)subscriber->readCount);
+        buffer = writeUint32(buffer, synchronisationSource);
+
+        /* Header extension with the sample rate and the UTC time in milliseconds */
+
+        buffer = writeUint16(buffer, RTP_EXTENSION_PROFILE);
+        buffer = writeUint16(buffer, RTP_EXTENSION_LENGTH);
+        buffer = writeUint32(buffer, segment->sampleRate);
+        buffer = writeUint32(buffer, (uint32_t)(timestamp >> 32));
+        buffer = writeUint32(buffer, (uint32_t)timestamp);
+
+        /* Samples in network byte order as for L16 */
+
+        int64_t samplesBehind = state->sampleCount - subscriber->readCount;
+
+        int32_t index = (int32_t)((state->bufferSize + state->writeIndex - samplesBehind % state->bufferSize) % state->bufferSize);
+
+        static int16_t samples[PACKET_SAMPLES];
+
+        Capture_copySamples(state, index, numberOfSamples, samples);
+
+        for (int32_t i = 0; i < numberOfSamples; i += 1) buffer = writeUint16(buffer, (uint16_t)samples[i]);
+
+        return serverProtocol == NT_TCP ? TCP_FRAMING_SIZE + packetLength : packetLength;
+
+    }
+
+    static bool sendPending(NT_subscriber_t *subscriber) {
+
+        uint8_t *data = subscriber->packet + subscriber->pendingOffset;
+
+        int32_t length = subscriber->pendingLength - subscriber->pendingOffset;
+
+        ssize_t sent;
+
+        if (serverProtocol == NT_TCP) {
+
+            sent = send(subscriber->socket, data, length, MSG_NOSIGNAL);
+
+        } else {
+
+            sent = sendto(serverSocket, data, length, MSG_NOSIGNAL, (struct sockaddr*)&subscriber->address, sizeof(struct sockaddr_in));
+
+            /* A datagram that cannot be sent is lost as it would be on the network */
+
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) sent = length;
+
+        }
+
+        if (sent < 0) {
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) removeSubscriber(subscriber);
+
+            return false;
+
+        }
+
+        subscriber->pendingOffset += (int32_t)sent;
+
+        if (subscriber->pendingOffset < subscriber->pendingLength) return false;
+
+        subscriber->pendingLength = 0;
+
+        return true;
+
+    }
+
+    static void serveSubscriber(NT_subscriber_t *subscriber, CP_state_t *state) {
+
+        if (serverProtocol == NT_UDP && time(NULL) - subscriber->lastSeen > SUBSCRIBER_TIMEOUT) {
+
+            removeSubscriber(subscriber);
+
+            return;
+
+        }
+
+        while (subscriber->active) {
+
+            if (subscriber->pendingLength > 0 && sendPending(subscriber) == false) return;
+
+            /* Skip ahead rather than let a slow subscriber fall behind the capture */
+
+            int64_t lag = state->sampleCount - subscriber->readCount;
+
+            if (lag > state->bufferSize / 2) {
+
+                Metrics_add(MT_NETWORK_DROPPED_SAMPLES, lag);
+
+                subscriber->sequence += (uint16_t)((lag + PACKET_SAMPLES - 1) / PACKET_SAMPLES);
+
+                subscriber->readCount = state->sampleCount;
+
+            }
+
+            /* Finish the previous segment before following a restart */
+
+            NT_segment_t *segment = &subscriber->segment;
+
+            int64_t endCount = state->sampleCount;
+
+            bool restarted = segment->startTime != state->startTime || segment->startCount != state->startCount;
+
+            if (restarted && (subscriber->readCount >= state->startCount || segment->sampleRate == 0)) {
+
+                segment->sampleRate = state->sampleRate;
+
+                segment->startTime = state->startTime;
+
+                segment->startCount = state->startCount;
+
+                subscriber->readCount = MAX(subscriber->readCount, state->startCount);
+
+                restarted = false;
+
+            }
+
+            if (restarted) endCount = state->startCount;
+
+            int64_t available = endCount - subscriber->readCount;
+
+            if (available <= 0 || (available < PACKET_SAMPLES && restarted == false)) return;
+
+            int32_t numberOfSamples = (int32_t)MIN(available, PACKET_SAMPLES);
+
+            subscriber->pendingLength = buildPacket(subscriber, state, numberOfSamples);
+
+            subscriber->pendingOffset = 0;
+
+            subscriber->readCount += numberOfSamples;
+
+            subscriber->sequence += 1;
+
+        }
+
+    }
+
+    static void *networkThreadBody(void *ptr) {
+
+        CP_state_t state;
+
+        while (true) {
+
+            usleep(SERVER_POLL_INTERVAL);
+
+            Capture_getState(&state);
+
+            acceptSubscribers(&state);
+
+            if (state.sampleRate == 0) continue;
+
+            for (int32_t i = 0; i < MAXIMUM_SUBSCRIBERS; i += 1) {
+
+                if (subscribers[i].active) serveSubscriber(subscribers + i, &state);
+
+            }
+
+        }
+
+        return NULL;
+
+    }
+
+    /* Public function */
+
+    bool Network_initialise(NT_protocol_t protocol, int32_t port, const char *bindAddress) {
+
+        serverProtocol = protocol;
+
+        synchronisationSource = (uint32_t)Time_getMillisecondUTC() ^ (uint32_t)getpid();
+
+        serverSocket = socket(AF_INET, protocol == NT_TCP ? SOCK_STREAM : SOCK_DGRAM, 0);
+
+        if (serverSocket < 0) return false;
+
+        int option = 1;
+
+        setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+        struct sockaddr_in address;
+
+        memset(&address, 0, sizeof(struct sockaddr_in));
+
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        /* Only listen beyond this machine when an address is given explicitly */
+
+        bool success = bindAddress == NULL || inet_pton(AF_INET, bindAddress, &address.sin_addr) == 1;
+
+        success = success && bind(serverSocket, (struct sockaddr*)&address, sizeof(struct sockaddr_in)) == 0;
+
+        if (protocol == NT_TCP) success = success && listen(serverSocket, MAXIMUM_SUBSCRIBERS) == 0;
+
+        success = success && fcntl(serverSocket, F_SETFL, fcntl(serverSocket, F_GETFL) | O_NONBLOCK) == 0;
+
+        /* Datagram subscription challenges use unpredictable nonces */
+
+        if (protocol == NT_UDP) success = success && (randomFile = open(RANDOM_DEVICE, O_RDONLY)) >= 0;
+
+        success = success && pthread_create(&networkThread, NULL, networkThreadBody, NULL) == 0;
+
+        if (success == false) {
+
+            close(serverSocket);
+
+            serverSocket = -1;
+
+        }
+
+        return success;
+
+    }
+
+#endif
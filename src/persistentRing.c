@@ -0,0 +1,181 @@
+/****************************************************************************
+ * persistentRing.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <string.h>
+
+#include "macros.h"
+#include "persistentRing.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    int16_t *PersistentRing_initialise(const char *path, int32_t bufferSize, PR_recovery_t *recovery) {
+
+        return NULL;
+
+    }
+
+    void PersistentRing_publish(int32_t sampleRate, int64_t sampleCount, int64_t startTime, int64_t startCount) { }
+
+    void PersistentRing_setFlushedCount(int64_t flushedCount) { }
+
+    void PersistentRing_sync(void) { }
+
+#else
+
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+
+    /* Header constants */
+
+    #define PERSISTENT_RING_ID              "AMLP"
+    #define PERSISTENT_RING_ID_LENGTH       4
+    #define PERSISTENT_RING_VERSION         1
+    #define PERSISTENT_RING_HEADER_SIZE     4096
+
+    #define MILLISECONDS_IN_SECOND          1000
+
+    /* The write index always equals the sample count modulo the buffer size so only counts are stored */
+
+    typedef struct {
+        char id[PERSISTENT_RING_ID_LENGTH];
+        uint32_t version;
+        uint32_t bufferSize;
+        volatile int32_t sampleRate;
+        volatile int64_t sampleCount;
+        volatile int64_t startTime;
+        volatile int64_t startCount;
+        volatile int64_t flushedCount;
+    } PR_header_t;
+
+    /* Mapping variables */
+
+    static PR_header_t *header;
+
+    static size_t mappingSize;
+
+    static bool headerReset;
+
+    /* Private function to find samples captured but never written to a WAV file */
+
+    static void findUnflushedSamples(PR_header_t *previous, int32_t bufferSize, PR_recovery_t *recovery) {
+
+        memset(recovery, 0, sizeof(PR_recovery_t));
+
+        bool valid = memcmp(previous->id, PERSISTENT_RING_ID, PERSISTENT_RING_ID_LENGTH) == 0 && previous->version == PERSISTENT_RING_VERSION && previous->bufferSize == (uint32_t)bufferSize;
+
+        if (valid == false || previous->sampleRate <= 0) return;
+
+        /* Only samples since the last start have a known time and only a buffer of them survive */
+
+        int64_t firstCount = MAX(previous->flushedCount, previous->startCount);
+
+        firstCount = MAX(firstCount, previous->sampleCount - bufferSize);
+
+        if (firstCount >= previous->sampleCount) return;
+
+        recovery->sampleRate = previous->sampleRate;
+
+        recovery->startIndex = (int32_t)(firstCount % bufferSize);
+
+        recovery->numberOfSamples = (int32_t)(previous->sampleCount - firstCount);
+
+        recovery->startTime = previous->startTime + ROUNDED_DIV((firstCount - previous->startCount) * MILLISECONDS_IN_SECOND, previous->sampleRate);
+
+    }
+
+    /* Public functions */
+
+    int16_t *PersistentRing_initialise(const char *path, int32_t bufferSize, PR_recovery_t *recovery) {
+
+        mappingSize = PERSISTENT_RING_HEADER_SIZE + (size_t)bufferSize * sizeof(int16_t);
+
+        int file = open(path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+
+        if (file < 0) return NULL;
+
+        struct stat status;
+
+        bool existing = fstat(file, &status) == 0 && (size_t)status.st_size == mappingSize;
+
+        if (existing == false && ftruncate(file, mappingSize) != 0) {
+
+            close(file);
+
+            return NULL;
+
+        }
+
+        void *memory = mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+
+        close(file);
+
+        if (memory == MAP_FAILED) return NULL;
+
+        header = (PR_header_t*)memory;
+
+        /* Report the unflushed span of an earlier run and then start a new header */
+
+        if (existing) {
+
+            findUnflushedSamples(header, bufferSize, recovery);
+
+        } else {
+
+            memset(recovery, 0, sizeof(PR_recovery_t));
+
+        }
+
+        return (int16_t*)((char*)memory + PERSISTENT_RING_HEADER_SIZE);
+
+    }
+
+    void PersistentRing_publish(int32_t sampleRate, int64_t sampleCount, int64_t startTime, int64_t startCount) {
+
+        if (header == NULL) return;
+
+        /* Reset the header on the first publish as any recovered samples have been saved by then */
+
+        if (headerReset == false) {
+
+            memset(header, 0, sizeof(PR_header_t));
+
+            header->version = PERSISTENT_RING_VERSION;
+
+            header->bufferSize = (uint32_t)((mappingSize - PERSISTENT_RING_HEADER_SIZE) / sizeof(int16_t));
+
+            memcpy(header->id, PERSISTENT_RING_ID, PERSISTENT_RING_ID_LENGTH);
+
+            headerReset = true;
+
+        }
+
+        header->sampleRate = sampleRate;
+
+        header->startTime = startTime;
+
+        header->startCount = startCount;
+
+        /* Publish the count last so that it never covers samples that are not yet in the buffer */
+
+        header->sampleCount = sampleCount;
+
+    }
+
+    void PersistentRing_setFlushedCount(int64_t flushedCount) {
+
+        if (header != NULL) header->flushedCount = flushedCount;
+
+    }
+
+    void PersistentRing_sync(void) {
+
+        if (header != NULL) msync(header, mappingSize, MS_ASYNC);
+
+    }
+
+#endif
@@ -0,0 +1,150 @@
+/****************************************************************************
+ * queue.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "queue.h"
+#include "xatomic.h"
+
+/* Bounded lock-free queue for many producers and a single consumer. Each slot has a sequence number which tells producers and the consumer whose turn it is */
+
+struct QU_queue_t {
+    int32_t capacity;
+    size_t itemSize;
+    atomic_int_fast64_t *sequences;
+    char *items;
+    atomic_int_fast64_t writePosition;
+    int64_t readPosition;
+};
+
+/* Private function */
+
+static inline void *getItem(QU_queue_t *queue, int64_t position) {
+
+    return queue->items + (size_t)(position & (queue->capacity - 1)) * queue->itemSize;
+
+}
+
+/* Public functions */
+
+QU_queue_t *Queue_create(int32_t number, size_t itemSize) {
+
+    QU_queue_t *queue = (QU_queue_t*)calloc(1, sizeof(QU_queue_t));
+
+    if (queue == NULL) return NULL;
+
+    /* Round the capacity up to a power of two so positions can be masked */
+
+    queue->capacity = 1;
+
+    while (queue->capacity < number) queue->capacity *= 2;
+
+    queue->itemSize = itemSize;
+
+    queue->sequences = (atomic_int_fast64_t*)calloc(queue->capacity, sizeof(atomic_int_fast64_t));
+
+    queue->items = (char*)calloc(queue->capacity, itemSize);
+
+    if (queue->sequences == NULL || queue->items == NULL) {
+
+        free(queue->sequences);
+
+        free(queue->items);
+
+        free(queue);
+
+        return NULL;
+
+    }
+
+    for (int32_t i = 0; i < queue->capacity; i += 1) atomic_init(queue->sequences + i, i);
+
+    atomic_init(&queue->writePosition, 0);
+
+    queue->readPosition = 0;
+
+    return queue;
+
+}
+
+void *Queue_claim(QU_queue_t *queue, int64_t *position) {
+
+    int64_t current = atomic_load_explicit(&queue->writePosition, memory_order_relaxed);
+
+    /* Claim the next free slot without taking a lock */
+
+    while (true) {
+
+        int64_t difference = atomic_load_explicit(queue->sequences + (current & (queue->capacity - 1)), memory_order_acquire) - current;
+
+        if (difference == 0) {
+
+            if (atomic_compare_exchange_weak_explicit(&queue->writePosition, &current, current + 1, memory_order_relaxed, memory_order_relaxed)) break;
+
+        } else if (difference < 0) {
+
+            return NULL;
+
+        } else {
+
+            current = atomic_load_explicit(&queue->writePosition, memory_order_relaxed);
+
+        }
+
+    }
+
+    *position = current;
+
+    return getItem(queue, current);
+
+}
+
+void Queue_publish(QU_queue_t *queue, int64_t position) {
+
+    /* Hand the filled slot to the consumer */
+
+    atomic_store_explicit(queue->sequences + (position & (queue->capacity - 1)), position + 1, memory_order_release);
+
+}
+
+bool Queue_push(QU_queue_t *queue, const void *item) {
+
+    int64_t position;
+
+    void *slot = Queue_claim(queue, &position);
+
+    if (slot == NULL) return false;
+
+    memcpy(slot, item, queue->itemSize);
+
+    Queue_publish(queue, position);
+
+    return true;
+
+}
+
+void *Queue_peek(QU_queue_t *queue) {
+
+    int64_t position = queue->readPosition;
+
+    if (atomic_load_explicit(queue->sequences + (position & (queue->capacity - 1)), memory_order_acquire) != position + 1) return NULL;
+
+    return getItem(queue, position);
+
+}
+
+void Queue_release(QU_queue_t *queue) {
+
+    int64_t position = queue->readPosition;
+
+    /* Hand the slot back to producers for the next lap */
+
+    atomic_store_explicit(queue->sequences + (position & (queue->capacity - 1)), position + queue->capacity, memory_order_release);
+
+    queue->readPosition += 1;
+
+}
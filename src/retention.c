@@ -0,0 +1,464 @@
+/****************************************************************************
+ * retention.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "retention.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <windows.h>
+    #define FILE_SEPARATOR "\\"
+#else
+    #include <dirent.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/statvfs.h>
+    #define FILE_SEPARATOR "/"
+#endif
+
+/* Index constants */
+
+#define INITIAL_NUMBER_OF_FILES         64
+#define PATH_BUFFER_SIZE                8192
+
+#define MAXIMUM_SCAN_DEPTH              4
+#define COPY_BUFFER_SIZE                65536
+
+#define WAV_EXTENSION                   ".WAV"
+
+/* Index entry */
+
+typedef struct {
+    char *filename;
+    int64_t size;
+    time_t startTime;
+} RT_file_t;
+
+/* Policy variables */
+
+static bool enabled;
+
+static int64_t maximumTotalBytes;
+
+static int64_t maximumFileAge;
+
+static int64_t minimumFreeSpace;
+
+static char directory[PATH_BUFFER_SIZE];
+
+static char archiveDirectory[PATH_BUFFER_SIZE];
+
+/* Index variables, oldest first */
+
+static RT_file_t *files;
+
+static int32_t numberOfFiles;
+
+static int32_t firstFile;
+
+static int32_t capacity;
+
+static int64_t totalBytes;
+
+/* Private functions */
+
+static RT_file_t *getFile(int32_t position) {
+
+    return files + (firstFile + position) % capacity;
+
+}
+
+static int64_t getFreeSpace(void) {
+
+    #if defined(_WIN32) || defined(_WIN64)
+
+        ULARGE_INTEGER freeBytes;
+
+        if (GetDiskFreeSpaceExA(directory, &freeBytes, NULL, NULL) == 0) return INT64_MAX;
+
+        return (int64_t)freeBytes.QuadPart;
+
+    #else
+
+        struct statvfs status;
+
+        if (statvfs(directory, &status) != 0) return INT64_MAX;
+
+        return (int64_t)status.f_bavail * (int64_t)status.f_frsize;
+
+    #endif
+
+}
+
+/* Private function to move a file to the archive, copying it when the archive is on another filesystem */
+
+static bool moveFile(const char *source, const char *destination) {
+
+    #if defined(_WIN32) || defined(_WIN64)
+
+        return MoveFileExA(source, destination, MOVEFILE_COPY_ALLOWED | MOVEFILE_WRITE_THROUGH) != 0;
+
+    #else
+
+        static char buffer[COPY_BUFFER_SIZE];
+
+        if (rename(source, destination) == 0) return true;
+
+        if (errno != EXDEV) return false;
+
+        FILE *input = fopen(source, "rb");
+
+        if (input == NULL) return false;
+
+        FILE *output = fopen(destination, "wb");
+
+        if (output == NULL) {
+
+            fclose(input);
+
+            return false;
+
+        }
+
+        bool success = true;
+
+        size_t count;
+
+        while (success && (count = fread(buffer, 1, COPY_BUFFER_SIZE, input)) > 0) success = fwrite(buffer, 1, count, output) == count;
+
+        success &= ferror(input) == 0;
+
+        success &= fflush(output) == 0 && fsync(fileno(output)) == 0;
+
+        fclose(input);
+
+        success &= fclose(output) == 0;
+
+        /* Only remove the original once the copy is safely on disk */
+
+        if (success) success = remove(source) == 0;
+
+        if (success == false) remove(destination);
+
+        return success;
+
+    #endif
+
+}
+
+static void forgetOldestFile(void) {
+
+    RT_file_t *file = getFile(0);
+
+    totalBytes -= file->size;
+
+    free(file->filename);
+
+    firstFile = (firstFile + 1) % capacity;
+
+    numberOfFiles -= 1;
+
+}
+
+static bool removeOldestFile(void) {
+
+    static char archiveFilename[2 * PATH_BUFFER_SIZE];
+
+    RT_file_t *file = getFile(0);
+
+    bool success;
+
+    errno = 0;
+
+    if (archiveDirectory[0] != 0) {
+
+        char *name = strrchr(file->filename, FILE_SEPARATOR[0]);
+
+        snprintf(archiveFilename, 2 * PATH_BUFFER_SIZE, "%s%s%s", archiveDirectory, FILE_SEPARATOR, name == NULL ? file->filename : name + 1);
+
+        success = moveFile(file->filename, archiveFilename);
+
+    } else {
+
+        success = remove(file->filename) == 0;
+
+    }
+
+    /* Forget a file removed elsewhere so that it does not block the policy but keep any file that could not be moved */
+
+    if (success || errno == ENOENT) forgetOldestFile();
+
+    return success;
+
+}
+
+/* Private functions to seed the index with files left by a previous run */
+
+static int compareFiles(const void *a, const void *b) {
+
+    const RT_file_t *fileA = (const RT_file_t*)a;
+
+    const RT_file_t *fileB = (const RT_file_t*)b;
+
+    if (fileA->startTime != fileB->startTime) return fileA->startTime < fileB->startTime ? -1 : 1;
+
+    return strcmp(fileA->filename, fileB->filename);
+
+}
+
+static bool isWavFile(const char *name) {
+
+    size_t length = strlen(name);
+
+    size_t extensionLength = strlen(WAV_EXTENSION);
+
+    return length > extensionLength && strcmp(name + length - extensionLength, WAV_EXTENSION) == 0;
+
+}
+
+static void scanDirectory(const char *path, int32_t depth) {
+
+    static char filename[PATH_BUFFER_SIZE];
+
+    /* Files in the archive have already been retired */
+
+    if (depth > MAXIMUM_SCAN_DEPTH || strcmp(path, archiveDirectory) == 0) return;
+
+    #if defined(_WIN32) || defined(_WIN64)
+
+        WIN32_FIND_DATAA findData;
+
+        snprintf(filename, PATH_BUFFER_SIZE, "%s%s*", path, FILE_SEPARATOR);
+
+        HANDLE find = FindFirstFileA(filename, &findData);
+
+        if (find == INVALID_HANDLE_VALUE) return;
+
+        do {
+
+            if (strcmp(findData.cFileName, ".") == 0 || strcmp(findData.cFileName, "..") == 0) continue;
+
+            if (snprintf(filename, PATH_BUFFER_SIZE, "%s%s%s", path, FILE_SEPARATOR, findData.cFileName) >= PATH_BUFFER_SIZE) continue;
+
+            if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+
+                char *subdirectory = strdup(filename);
+
+                if (subdirectory == NULL) continue;
+
+                scanDirectory(subdirectory, depth + 1);
+
+                free(subdirectory);
+
+            } else if (isWavFile(findData.cFileName)) {
+
+                ULARGE_INTEGER size = {.LowPart = findData.nFileSizeLow, .HighPart = findData.nFileSizeHigh};
+
+                ULARGE_INTEGER modified = {.LowPart = findData.ftLastWriteTime.dwLowDateTime, .HighPart = findData.ftLastWriteTime.dwHighDateTime};
+
+                Retention_addFile(filename, (int64_t)size.QuadPart, (time_t)(modified.QuadPart / 10000000ULL - 11644473600ULL));
+
+            }
+
+        } while (FindNextFileA(find, &findData) != 0);
+
+        FindClose(find);
+
+    #else
+
+        DIR *dir = opendir(path);
+
+        if (dir == NULL) return;
+
+        struct dirent *entry;
+
+        while ((entry = readdir(dir)) != NULL) {
+
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+
+            if (snprintf(filename, PATH_BUFFER_SIZE, "%s%s%s", path, FILE_SEPARATOR, entry->d_name) >= PATH_BUFFER_SIZE) continue;
+
+            struct stat status;
+
+            if (stat(filename, &status) != 0) continue;
+
+            if (S_ISDIR(status.st_mode)) {
+
+                char *subdirectory = strdup(filename);
+
+                if (subdirectory == NULL) continue;
+
+                scanDirectory(subdirectory, depth + 1);
+
+                free(subdirectory);
+
+            } else if (S_ISREG(status.st_mode) && isWavFile(entry->d_name)) {
+
+                Retention_addFile(filename, (int64_t)status.st_size, status.st_mtime);
+
+            }
+
+        }
+
+        closedir(dir);
+
+    #endif
+
+}
+
+/* Public functions */
+
+bool Retention_initialise(const char *destination, int64_t maximumBytes, int64_t maximumAge, int64_t minimumFreeBytes, const char *archiveDestination) {
+
+    strncpy(directory, destination, PATH_BUFFER_SIZE - 1);
+
+    if (archiveDestination != NULL) strncpy(archiveDirectory, archiveDestination, PATH_BUFFER_SIZE - 1);
+
+    maximumTotalBytes = maximumBytes;
+
+    maximumFileAge = maximumAge;
+
+    minimumFreeSpace = minimumFreeBytes;
+
+    files = (RT_file_t*)calloc(INITIAL_NUMBER_OF_FILES, sizeof(RT_file_t));
+
+    capacity = INITIAL_NUMBER_OF_FILES;
+
+    enabled = files != NULL;
+
+    if (enabled == false) return false;
+
+    /* Seed the index with existing recordings so they are subject to the policy after a restart */
+
+    scanDirectory(directory, 0);
+
+    if (numberOfFiles > 1) qsort(files, numberOfFiles, sizeof(RT_file_t), compareFiles);
+
+    return true;
+
+}
+
+bool Retention_addFile(const char *filename, int64_t size, time_t startTime) {
+
+    if (enabled == false) return true;
+
+    if (numberOfFiles == capacity) {
+
+        RT_file_t *newFiles = (RT_file_t*)calloc(2 * capacity, sizeof(RT_file_t));
+
+        if (newFiles == NULL) return false;
+
+        for (int32_t i = 0; i < numberOfFiles; i += 1) memcpy(newFiles + i, getFile(i), sizeof(RT_file_t));
+
+        free(files);
+
+        files = newFiles;
+
+        firstFile = 0;
+
+        capacity *= 2;
+
+    }
+
+    char *copy = (char*)malloc(strlen(filename) + 1);
+
+    if (copy == NULL) return false;
+
+    strcpy(copy, filename);
+
+    RT_file_t *file = files + (firstFile + numberOfFiles) % capacity;
+
+    file->filename = copy;
+
+    file->size = size;
+
+    file->startTime = startTime;
+
+    numberOfFiles += 1;
+
+    totalBytes += size;
+
+    return true;
+
+}
+
+void Retention_updateFile(const char *filename, int64_t additionalSize) {
+
+    if (enabled == false || numberOfFiles == 0) return;
+
+    /* Appends only ever extend the most recent file */
+
+    RT_file_t *file = getFile(numberOfFiles - 1);
+
+    if (strcmp(file->filename, filename) != 0) return;
+
+    file->size += additionalSize;
+
+    totalBytes += additionalSize;
+
+}
+
+bool Retention_enforce(time_t currentTime) {
+
+    if (enabled == false) return true;
+
+    bool success = true;
+
+    int64_t freeSpace = minimumFreeSpace > 0 ? getFreeSpace() : INT64_MAX;
+
+    /* Never remove the most recent file as it may still be appended to */
+
+    while (numberOfFiles > 1) {
+
+        RT_file_t *file = getFile(0);
+
+        bool tooLarge = maximumTotalBytes > 0 && totalBytes > maximumTotalBytes;
+
+        bool tooOld = maximumFileAge > 0 && currentTime - file->startTime > maximumFileAge;
+
+        bool tooFull = minimumFreeSpace > 0 && freeSpace < minimumFreeSpace;
+
+        if (tooLarge == false && tooOld == false && tooFull == false) break;
+
+        int64_t size = file->size;
+
+        int32_t previousNumberOfFiles = numberOfFiles;
+
+        bool removed = removeOldestFile();
+
+        success &= removed;
+
+        /* Stop if the file could not be moved rather than retry it indefinitely */
+
+        if (numberOfFiles == previousNumberOfFiles) break;
+
+        if (removed == false || minimumFreeSpace == 0) continue;
+
+        if (archiveDirectory[0] == 0) {
+
+            freeSpace += size;
+
+        } else {
+
+            /* An archive move only frees space when the archive is on another filesystem */
+
+            int64_t previousFreeSpace = freeSpace;
+
+            freeSpace = getFreeSpace();
+
+            if (tooLarge == false && tooOld == false && freeSpace <= previousFreeSpace) break;
+
+        }
+
+    }
+
+    return success;
+
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+ * sharedRing.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sharedRing.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    int16_t *SharedRing_initialise(const char *name, int32_t bufferSize) {
+
+        return NULL;
+
+    }
+
+    void SharedRing_publish(int32_t sampleRate, int32_t writeIndex, int64_t sampleCount, int64_t startTime, int64_t startCount) { }
+
+    void SharedRing_close(void) { }
+
+#else
+
+    #include <string.h>
+
+    #include "sharedRingClient.h"
+
+    /* Shared memory constants */
+
+    #define SHARED_RING_NAME_SIZE       256
+
+    /* Shared memory variables */
+
+    static SR_header_t *header;
+
+    static size_t mappingSize;
+
+    static char sharedRingName[SHARED_RING_NAME_SIZE];
+
+    /* Public functions */
+
+    int16_t *SharedRing_initialise(const char *name, int32_t bufferSize) {
+
+        if (strlen(name) >= SHARED_RING_NAME_SIZE) return NULL;
+
+        strncpy(sharedRingName, name, SHARED_RING_NAME_SIZE - 1);
+
+        mappingSize = SHARED_RING_HEADER_SIZE + (size_t)bufferSize * sizeof(int16_t);
+
+        /* Replace any ring left behind by an earlier process */
+
+        shm_unlink(sharedRingName);
+
+        int file = shm_open(sharedRingName, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+        if (file < 0) return NULL;
+
+        void *memory = ftruncate(file, mappingSize) == 0 ? mmap(NULL, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+
+        close(file);
+
+        if (memory == MAP_FAILED) {
+
+            shm_unlink(sharedRingName);
+
+            return NULL;
+
+        }
+
+        header = (SR_header_t*)memory;
+
+        header->version = SHARED_RING_VERSION;
+        header->headerSize = SHARED_RING_HEADER_SIZE;
+        header->bufferSize = bufferSize;
+
+        atomic_store_explicit(&header->sequence, 0, memory_order_relaxed);
+
+        /* Write the identifier last so that clients never see a partial header */
+
+        atomic_thread_fence(memory_order_release);
+
+        memcpy(header->id, SHARED_RING_ID, SHARED_RING_ID_LENGTH);
+
+        return (int16_t*)((char*)memory + SHARED_RING_HEADER_SIZE);
+
+    }
+
+    void SharedRing_publish(int32_t sampleRate, int32_t writeIndex, int64_t sampleCount, int64_t startTime, int64_t startCount) {
+
+        if (header == NULL) return;
+
+        /* Sequence lock so that readers take a consistent snapshot without blocking capture */
+
+        uint32_t sequence = atomic_load_explicit(&header->sequence, memory_order_relaxed);
+
+        atomic_store_explicit(&header->sequence, sequence + 1, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_release);
+
+        atomic_store_explicit(&header->sampleRate, sampleRate, memory_order_relaxed);
+        atomic_store_explicit(&header->writeIndex, writeIndex, memory_order_relaxed);
+        atomic_store_explicit(&header->sampleCount, sampleCount, memory_order_relaxed);
+        atomic_store_explicit(&header->startTime, startTime, memory_order_relaxed);
+        atomic_store_explicit(&header->startCount, startCount, memory_order_relaxed);
+
+        atomic_store_explicit(&header->sequence, sequence + 2, memory_order_release);
+
+    }
+
+    void SharedRing_close(void) {
+
+        if (header == NULL) return;
+
+        shm_unlink(sharedRingName);
+
+    }
+
+#endif
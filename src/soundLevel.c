@@ -0,0 +1,409 @@
+/****************************************************************************
+ * soundLevel.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "xtime.h"
+#include "xatomic.h"
+#include "biquad.h"
+#include "macros.h"
+#include "logger.h"
+#include "capture.h"
+#include "threads.h"
+#include "soundLevel.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+/* Maths constants */
+
+#ifndef M_PI
+#define M_PI                            3.14159265358979323846
+#endif
+
+#ifndef M_TWOPI
+#define M_TWOPI                         (2.0 * M_PI)
+#endif
+
+/* Sound level constants */
+
+#define SOUND_LEVEL_POLL_INTERVAL       100000
+#define SOUND_LEVEL_CHUNK_SIZE          4096
+#define TIMESTAMP_BUFFER_SIZE           64
+
+#define INT16_SCALE                     32768.0
+#define MINIMUM_DECIBELS                -120.0
+
+#define LOG_HEADER                      "time,duration,LAeq,LCeq\n"
+
+/* Time constants */
+
+#define MILLISECONDS_IN_SECOND          1000
+#define SECONDS_IN_MINUTE               60
+
+#define YEAR_OFFSET                     1900
+#define MONTH_OFFSET                    1
+
+/* Weighting pole frequencies from IEC 61672-1 with both weightings normalised at 1kHz */
+
+#define LOW_POLE_FREQUENCY              20.598997
+#define MID_POLE_FREQUENCY_1            107.65265
+#define MID_POLE_FREQUENCY_2            737.86223
+#define HIGH_POLE_FREQUENCY             12194.217
+
+#define REFERENCE_FREQUENCY             1000.0
+
+/* Energy integrated over one interval */
+
+typedef struct {
+    int64_t key;
+    int64_t numberOfSamples;
+    double aWeightedEnergy;
+    double cWeightedEnergy;
+} SL_interval_t;
+
+/* Filter variables. C weighting is the low and high pole sections and A weighting adds the mid section to its output */
+
+static uint32_t filterSampleRate;
+
+static BQ_filterCoefficients_t lowPoleCoefficients;
+
+static BQ_filterCoefficients_t highPoleCoefficients;
+
+static BQ_filterCoefficients_t midPoleCoefficients;
+
+static BQ_filter_t lowPoleFilter;
+
+static BQ_filter_t highPoleFilter;
+
+static BQ_filter_t midPoleFilter;
+
+static double aWeightingScale;
+
+static double cWeightingScale;
+
+/* Interval variables */
+
+static SL_interval_t second = {.key = -1};
+
+static SL_interval_t minute = {.key = -1};
+
+static int64_t samplesToBoundary;
+
+/* Log variables */
+
+static FILE *logFile;
+
+static pthread_t soundLevelThread;
+
+static atomic_bool running;
+
+/* Private functions to design and apply the weighting filters */
+
+static void designFilters(uint32_t sampleRate) {
+
+    double lowPole = M_TWOPI * LOW_POLE_FREQUENCY;
+
+    double midPole1 = M_TWOPI * MID_POLE_FREQUENCY_1;
+
+    double midPole2 = M_TWOPI * MID_POLE_FREQUENCY_2;
+
+    Biquad_designBilinearFilter(&lowPoleCoefficients, sampleRate, 1.0, 0.0, 0.0, 1.0, 2.0 * lowPole, lowPole * lowPole);
+
+    Biquad_designBilinearFilter(&midPoleCoefficients, sampleRate, 1.0, 0.0, 0.0, 1.0, midPole1 + midPole2, midPole1 * midPole2);
+
+    /* The matched z transform keeps the high poles in place at low sample rates where the bilinear transform would pull them well inside the audio band. A pair of zeros then matches the analog gain at the Nyquist frequency */
+
+    double highPole = exp(-M_TWOPI * HIGH_POLE_FREQUENCY / (double)sampleRate);
+
+    double nyquistRatio = (double)sampleRate / 2.0 / HIGH_POLE_FREQUENCY;
+
+    double zeroGain = sqrt(1.0 / (1.0 + nyquistRatio * nyquistRatio)) * (1.0 + highPole) / (1.0 - highPole);
+
+    double highZero = (1.0 - zeroGain) / (1.0 + zeroGain);
+
+    double numeratorScale = (1.0 - highPole) * (1.0 - highPole) / ((1.0 + highZero) * (1.0 + highZero));
+
+    highPoleCoefficients.B0_A0 = numeratorScale;
+    highPoleCoefficients.B1_A0 = 2.0 * highZero * numeratorScale;
+    highPoleCoefficients.B2_A0 = highZero * highZero * numeratorScale;
+    highPoleCoefficients.A1_A0 = -2.0 * highPole;
+    highPoleCoefficients.A2_A0 = highPole * highPole;
+
+    /* Scale the energies so both weightings have unity gain at the reference frequency and full scale is 0dB */
+
+    double cWeightingGain = Biquad_getGain(&lowPoleCoefficients, sampleRate, REFERENCE_FREQUENCY) * Biquad_getGain(&highPoleCoefficients, sampleRate, REFERENCE_FREQUENCY);
+
+    double aWeightingGain = cWeightingGain * Biquad_getGain(&midPoleCoefficients, sampleRate, REFERENCE_FREQUENCY);
+
+    cWeightingScale = 1.0 / (cWeightingGain * cWeightingGain * INT16_SCALE * INT16_SCALE);
+
+    aWeightingScale = 1.0 / (aWeightingGain * aWeightingGain * INT16_SCALE * INT16_SCALE);
+
+    filterSampleRate = sampleRate;
+
+}
+
+static void resetFilters(uint32_t sampleRate) {
+
+    if (sampleRate != filterSampleRate) designFilters(sampleRate);
+
+    Biquad_initialise(&lowPoleFilter);
+
+    Biquad_initialise(&highPoleFilter);
+
+    Biquad_initialise(&midPoleFilter);
+
+}
+
+static void filterSamples(int16_t *samples, int32_t numberOfSamples) {
+
+    double aWeightedEnergy = 0.0;
+
+    double cWeightedEnergy = 0.0;
+
+    for (int32_t i = 0; i < numberOfSamples; i += 1) {
+
+        double cWeightedSample = Biquad_applyFilter(Biquad_applyFilter(samples[i], &lowPoleFilter, &lowPoleCoefficients), &highPoleFilter, &highPoleCoefficients);
+
+        double aWeightedSample = Biquad_applyFilter(cWeightedSample, &midPoleFilter, &midPoleCoefficients);
+
+        cWeightedEnergy += cWeightedSample * cWeightedSample;
+
+        aWeightedEnergy += aWeightedSample * aWeightedSample;
+
+    }
+
+    second.aWeightedEnergy += aWeightedEnergy * aWeightingScale;
+
+    second.cWeightedEnergy += cWeightedEnergy * cWeightingScale;
+
+    second.numberOfSamples += numberOfSamples;
+
+}
+
+/* Private functions to write intervals to the log */
+
+static double getDecibels(double energy, int64_t numberOfSamples) {
+
+    if (energy <= 0.0) return MINIMUM_DECIBELS;
+
+    return MAX(MINIMUM_DECIBELS, 10.0 * log10(energy / numberOfSamples));
+
+}
+
+static void writeInterval(SL_interval_t *interval, int32_t duration) {
+
+    static char timestamp[TIMESTAMP_BUFFER_SIZE];
+
+    if (interval->numberOfSamples > 0) {
+
+        struct tm time;
+
+        time_t rawTime = (time_t)(interval->key * duration);
+
+        Time_gmTime(&rawTime, &time);
+
+        sprintf(timestamp, "%04d-%02d-%02dT%02d:%02d:%02dZ", YEAR_OFFSET + time.tm_year, MONTH_OFFSET + time.tm_mon, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
+
+        fprintf(logFile, "%s,%d,%.1f,%.1f\n", timestamp, duration, getDecibels(interval->aWeightedEnergy, interval->numberOfSamples), getDecibels(interval->cWeightedEnergy, interval->numberOfSamples));
+
+        if (fflush(logFile) != 0) Logger_log(LG_ERROR, LG_CAPTURE, "Could not write to sound level log.");
+
+    }
+
+    interval->numberOfSamples = 0;
+
+    interval->aWeightedEnergy = 0.0;
+
+    interval->cWeightedEnergy = 0.0;
+
+}
+
+/* Private functions to close the previous second and find the samples remaining in the next */
+
+static void closeSecond(void) {
+
+    minute.numberOfSamples += second.numberOfSamples;
+
+    minute.aWeightedEnergy += second.aWeightedEnergy;
+
+    minute.cWeightedEnergy += second.cWeightedEnergy;
+
+    writeInterval(&second, 1);
+
+}
+
+static void startSecond(CP_state_t *segment, int64_t readCount) {
+
+    int64_t time = segment->startTime + (readCount - segment->startCount) * MILLISECONDS_IN_SECOND / segment->sampleRate;
+
+    int64_t key = time / MILLISECONDS_IN_SECOND;
+
+    int64_t boundaryCount = segment->startCount + (((key + 1) * MILLISECONDS_IN_SECOND - segment->startTime) * segment->sampleRate + MILLISECONDS_IN_SECOND - 1) / MILLISECONDS_IN_SECOND;
+
+    samplesToBoundary = MAX(1, boundaryCount - readCount);
+
+    /* A restart can continue the same second so only close intervals when the time moves on */
+
+    if (key != second.key) {
+
+        closeSecond();
+
+        second.key = key;
+
+    }
+
+    if (key / SECONDS_IN_MINUTE != minute.key) {
+
+        writeInterval(&minute, SECONDS_IN_MINUTE);
+
+        minute.key = key / SECONDS_IN_MINUTE;
+
+    }
+
+}
+
+/* Private function to process samples from the ring */
+
+static void processSamples(CP_state_t *segment, CP_state_t *latest, int64_t *readCount, int64_t endCount) {
+
+    static int16_t samples[SOUND_LEVEL_CHUNK_SIZE];
+
+    while (*readCount < endCount) {
+
+        if (samplesToBoundary == 0) startSecond(segment, *readCount);
+
+        int32_t numberOfSamples = (int32_t)MIN(MIN(endCount - *readCount, samplesToBoundary), SOUND_LEVEL_CHUNK_SIZE);
+
+        /* Locate the first sample relative to the most recent write position */
+
+        int64_t samplesBehind = latest->sampleCount - *readCount;
+
+        int32_t index = (int32_t)((latest->bufferSize + latest->writeIndex - samplesBehind % latest->bufferSize) % latest->bufferSize);
+
+        Capture_copySamples(latest, index, numberOfSamples, samples);
+
+        filterSamples(samples, numberOfSamples);
+
+        *readCount += numberOfSamples;
+
+        samplesToBoundary -= numberOfSamples;
+
+    }
+
+}
+
+static void *soundLevelThreadBody(void *ptr) {
+
+    CP_state_t state;
+
+    CP_state_t segment;
+
+    Capture_getState(&state);
+
+    memcpy(&segment, &state, sizeof(CP_state_t));
+
+    int64_t readCount = state.sampleCount;
+
+    if (segment.sampleRate > 0) resetFilters(segment.sampleRate);
+
+    while (atomic_load(&running)) {
+
+        usleep(SOUND_LEVEL_POLL_INTERVAL);
+
+        Capture_getState(&state);
+
+        if (state.sampleRate == 0) continue;
+
+        /* Skip ahead rather than fall behind the capture */
+
+        if (state.sampleCount - readCount > state.bufferSize / 2) {
+
+            readCount = state.sampleCount;
+
+            samplesToBoundary = 0;
+
+        }
+
+        /* Finish the previous segment before following a restart */
+
+        if (state.startTime != segment.startTime || state.startCount != segment.startCount) {
+
+            if (segment.sampleRate > 0) processSamples(&segment, &state, &readCount, MAX(readCount, state.startCount));
+
+            memcpy(&segment, &state, sizeof(CP_state_t));
+
+            readCount = MAX(readCount, state.startCount);
+
+            samplesToBoundary = 0;
+
+            resetFilters(segment.sampleRate);
+
+        }
+
+        processSamples(&segment, &state, &readCount, state.sampleCount);
+
+    }
+
+    /* Write the partial second and minute at shutdown */
+
+    closeSecond();
+
+    writeInterval(&minute, SECONDS_IN_MINUTE);
+
+    fclose(logFile);
+
+    return NULL;
+
+}
+
+/* Public functions */
+
+bool SoundLevel_initialise(const char *path) {
+
+    logFile = fopen(path, "a");
+
+    if (logFile == NULL) return false;
+
+    /* Start a new log with the column names */
+
+    fseek(logFile, 0, SEEK_END);
+
+    bool success = ftell(logFile) > 0 || fputs(LOG_HEADER, logFile) != EOF;
+
+    atomic_store(&running, true);
+
+    success = success && pthread_create(&soundLevelThread, NULL, soundLevelThreadBody, NULL) == 0;
+
+    if (success == false) {
+
+        atomic_store(&running, false);
+
+        fclose(logFile);
+
+    }
+
+    return success;
+
+}
+
+void SoundLevel_close(void) {
+
+    if (atomic_load(&running) == false) return;
+
+    atomic_store(&running, false);
+
+    pthread_join(soundLevelThread, NULL);
+
+}
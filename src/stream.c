@@ -0,0 +1,262 @@
+/****************************************************************************
+ * stream.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "macros.h"
+#include "logger.h"
+#include "stream.h"
+#include "capture.h"
+#include "metrics.h"
+#include "threads.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    bool Stream_initialise(const char *path) {
+
+        return false;
+
+    }
+
+#else
+
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <signal.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+
+    /* Stream constants */
+
+    #define STREAM_PATH_SIZE                1024
+    #define STREAM_FRAME_SIZE               4096
+    #define STREAM_POLL_INTERVAL            20000
+
+    #define STANDARD_OUTPUT_PATH            "-"
+
+    #define MILLISECONDS_IN_SECOND          1000
+
+    /* Stream variables */
+
+    static int streamFile = -1;
+
+    static bool usingStandardOutput;
+
+    static pthread_t streamThread;
+
+    static char streamPath[STREAM_PATH_SIZE];
+
+    /* Private functions to write frames */
+
+    static bool writeFully(const void *data, size_t length) {
+
+        const char *bytes = (const char*)data;
+
+        while (length > 0) {
+
+            ssize_t written = write(streamFile, bytes, length);
+
+            if (written < 0 && errno == EINTR) continue;
+
+            if (written <= 0) return false;
+
+            bytes += written;
+
+            length -= written;
+
+        }
+
+        return true;
+
+    }
+
+    static bool writeFrames(CP_state_t *segment, CP_state_t *latest, int64_t *readCount, int64_t endCount) {
+
+        static ST_frameHeader_t header = {.id = "AMLS"};
+
+        static int16_t samples[STREAM_FRAME_SIZE];
+
+        while (*readCount < endCount) {
+
+            int32_t numberOfSamples = (int32_t)MIN(endCount - *readCount, STREAM_FRAME_SIZE);
+
+            /* Locate the first sample relative to the most recent write position */
+
+            int64_t samplesBehind = latest->sampleCount - *readCount;
+
+            int32_t index = (int32_t)((latest->bufferSize + latest->writeIndex - samplesBehind % latest->bufferSize) % latest->bufferSize);
+
+            Capture_copySamples(latest, index, numberOfSamples, samples);
+
+            /* Drop the copy if the capture lapped the reader while a previous frame was blocked */
+
+            CP_state_t current;
+
+            Capture_getState(&current);
+
+            int64_t lag = current.sampleCount - *readCount;
+
+            if (lag > current.bufferSize) {
+
+                Metrics_add(MT_STREAM_DROPPED_SAMPLES, lag);
+
+                *readCount = current.sampleCount;
+
+                return true;
+
+            }
+
+            /* Write the header and the samples */
+
+            header.sampleRate = segment->sampleRate;
+
+            header.numberOfSamples = numberOfSamples;
+
+            header.sampleCount = *readCount;
+
+            header.timestamp = segment->startTime + ROUNDED_DIV((*readCount - segment->startCount) * MILLISECONDS_IN_SECOND, segment->sampleRate);
+
+            bool success = writeFully(&header, sizeof(ST_frameHeader_t));
+
+            success = success && writeFully(samples, numberOfSamples * sizeof(int16_t));
+
+            if (success == false) return false;
+
+            *readCount += numberOfSamples;
+
+        }
+
+        return true;
+
+    }
+
+    static bool openStream(void) {
+
+        if (usingStandardOutput) return streamFile >= 0;
+
+        streamFile = open(streamPath, O_WRONLY);
+
+        return streamFile >= 0;
+
+    }
+
+    static void *streamThreadBody(void *ptr) {
+
+        CP_state_t state;
+
+        CP_state_t segment;
+
+        while (openStream() == false) usleep(STREAM_POLL_INTERVAL);
+
+        Capture_getState(&state);
+
+        memcpy(&segment, &state, sizeof(CP_state_t));
+
+        int64_t readCount = state.sampleCount;
+
+        while (true) {
+
+            usleep(STREAM_POLL_INTERVAL);
+
+            Capture_getState(&state);
+
+            if (state.sampleRate == 0) continue;
+
+            /* Drop samples rather than let a slow reader fall behind the capture */
+
+            int64_t lag = state.sampleCount - readCount;
+
+            if (lag > state.bufferSize / 2) {
+
+                Metrics_add(MT_STREAM_DROPPED_SAMPLES, lag);
+
+                readCount = state.sampleCount;
+
+            }
+
+            /* Finish the previous segment before following a restart */
+
+            bool success = true;
+
+            if (state.startTime != segment.startTime || state.startCount != segment.startCount) {
+
+                if (segment.sampleRate > 0) success = writeFrames(&segment, &state, &readCount, MAX(readCount, state.startCount));
+
+                memcpy(&segment, &state, sizeof(CP_state_t));
+
+                readCount = MAX(readCount, state.startCount);
+
+            }
+
+            success = success && writeFrames(&segment, &state, &readCount, state.sampleCount);
+
+            if (success) continue;
+
+            /* Wait for a new reader if the current one has gone */
+
+            if (usingStandardOutput) {
+
+                Logger_log(LG_ERROR, LG_STREAM, "Standard output stream closed.");
+
+                return NULL;
+
+            }
+
+            close(streamFile);
+
+            streamFile = -1;
+
+            while (openStream() == false) usleep(STREAM_POLL_INTERVAL);
+
+            Capture_getState(&state);
+
+            Metrics_add(MT_STREAM_DROPPED_SAMPLES, state.sampleCount - readCount);
+
+            readCount = state.sampleCount;
+
+        }
+
+        return NULL;
+
+    }
+
+    /* Public function */
+
+    bool Stream_initialise(const char *path) {
+
+        if (strlen(path) >= STREAM_PATH_SIZE) return false;
+
+        strncpy(streamPath, path, STREAM_PATH_SIZE - 1);
+
+        usingStandardOutput = strcmp(streamPath, STANDARD_OUTPUT_PATH) == 0;
+
+        /* A closed reader should end the write rather than the process */
+
+        signal(SIGPIPE, SIG_IGN);
+
+        if (usingStandardOutput) {
+
+            /* Keep the original standard output for samples and send messages to standard error */
+
+            streamFile = dup(STDOUT_FILENO);
+
+            if (streamFile < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) return false;
+
+        } else {
+
+            struct stat status;
+
+            if (stat(streamPath, &status) != 0 && mkfifo(streamPath, S_IRUSR | S_IWUSR) != 0) return false;
+
+        }
+
+        return pthread_create(&streamThread, NULL, streamThreadBody, NULL) == 0;
+
+    }
+
+#endif
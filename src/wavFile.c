@@ -4,21 +4,42 @@
  * January 2023
  *****************************************************************************/
 
+#if defined(__linux__)
+    #define _GNU_SOURCE
+#endif
+
+#include <math.h>
+#include <errno.h>
 #include <time.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 
 #include "xtime.h"
+#include "cpu.h"
+#include "macros.h"
 #include "wavFile.h"
+#include "xdirectory.h"
+
+#if IS_X86
+    #include <immintrin.h>
+#endif
+
+#if IS_ARM
+    #include <arm_neon.h>
+#endif
 
 #if defined(_WIN32) || defined(_WIN64)
     #include <io.h>
-    #define F_OK 0
-    #define access _access
+    #include <windows.h>
 #else
-    #include <unistd.h>   
+    #include <fcntl.h>
+    #include <stdlib.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
 #endif
 
 /* Useful time constants */
@@ -39,8 +60,25 @@
 /* WAV header constants */
 
 #define PCM_FORMAT                              1
+#define EXTENSIBLE_FORMAT                       0xFFFE
 #define NUMBER_OF_CHANNELS                      1
 #define NUMBER_OF_BITS_IN_INT16                 16
+#define FRONT_CENTRE_CHANNEL_MASK               0x4
+#define QUADRAPHONIC_CHANNEL_MASK               0x33
+#define MAXIMUM_PCM_CHANNELS                    2
+
+#define BITS_IN_BYTE                            8
+
+/* Sample conversion constants */
+
+#define INT16_SCALE                             32768.0f
+#define INT24_SCALE                             8388608.0f
+
+#define CONVERSION_BUFFER_SIZE                  16384
+#define SSE_WIDTH                               4
+#define AVX2_WIDTH                              8
+#define AVX512_WIDTH                            16
+#define NEON_WIDTH                              4
 
 /* Cross platform macros */
 
@@ -50,6 +88,71 @@
     #define FILE_SEPARATOR "/"
 #endif
 
+/* Buffer constant */
+
+#define FILE_DESTINATION_BUFFER_SIZE            8192
+
+/* Direct I/O constants */
+
+#define DIRECT_BLOCK_SIZE                       4096
+#define DIRECT_STAGING_SIZE                     (256 * DIRECT_BLOCK_SIZE)
+
+/* Durability variables */
+
+static WAV_durability_t durabilityPolicy = WAV_SYNC_NONE;
+
+static int32_t durabilityInterval;
+
+static time_t previousSyncTime;
+
+/* Sample format variables */
+
+static int32_t bytesPerSample[] = {[WAV_INT16] = 2, [WAV_INT24] = 3, [WAV_FLOAT32] = 4};
+
+static WAV_sampleFormat_t bufferFormat = WAV_INT16;
+
+static WAV_sampleFormat_t fileFormat = WAV_INT16;
+
+static int32_t bufferBytesPerSample = NUMBER_OF_BYTES_IN_SAMPLE;
+
+static int32_t fileBytesPerSample = NUMBER_OF_BYTES_IN_SAMPLE;
+
+static int32_t numberOfChannels = NUMBER_OF_CHANNELS;
+
+static int32_t bufferBytesPerFrame = NUMBER_OF_BYTES_IN_SAMPLE;
+
+static int32_t fileBytesPerFrame = NUMBER_OF_BYTES_IN_SAMPLE;
+
+static int32_t headerSize = sizeof(WAV_header_t) - sizeof(wavFormatExtension_t);
+
+/* Float conversion kernel selected for the instruction set */
+
+static void convertFloatToIntegerGeneric(int32_t *destination, float *source, int32_t numberOfSamples, float scale, float maximum);
+
+static void (*convertFloatToInteger)(int32_t *destination, float *source, int32_t numberOfSamples, float scale, float maximum) = convertFloatToIntegerGeneric;
+
+/* Format extension subtype GUIDs, which differ only in the first byte */
+
+static uint8_t pcmSubFormat[LENGTH_OF_GUID] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+static uint8_t floatSubFormat[LENGTH_OF_GUID] = {0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71};
+
+/* Writer variable */
+
+static WAV_writer_t writerMode = WAV_STDIO_WRITER;
+
+/* Direct I/O state kept between writes to the same file */
+
+typedef struct {
+    char filename[FILE_DESTINATION_BUFFER_SIZE];
+    int64_t length;
+    char *staging;
+    char *headBlock;
+    char *tailBlock;
+} WAV_directFile_t;
+
+static WAV_directFile_t directFile;
+
 /* Default file header */
 
 static WAV_header_t defaultHeader = {
@@ -71,190 +174,1270 @@ static WAV_header_t defaultHeader = {
     .data = {.id = "data", .size = 0}
 };
 
-/* Functions to set WAV header details and comment */
+/* Functions to select the sample format of the buffer and of the file */
 
-void WavFile_initialiseHeader(WAV_header_t *header) {
+static bool useExtensibleFormat(void) {
 
-    memcpy(header, &defaultHeader, sizeof(WAV_header_t));
+    return fileFormat != WAV_INT16 || numberOfChannels > MAXIMUM_PCM_CHANNELS;
 
 }
 
-void WavFile_setHeaderDetails(WAV_header_t *header, uint32_t sampleRate, uint32_t numberOfSamples) {
+void WavFile_setSampleFormats(WAV_sampleFormat_t newBufferFormat, WAV_sampleFormat_t newFileFormat, int32_t newNumberOfChannels) {
 
-    header->wavFormat.samplesPerSecond = sampleRate;
-    header->wavFormat.bytesPerSecond = NUMBER_OF_BYTES_IN_SAMPLE * sampleRate;
-    header->data.size = NUMBER_OF_BYTES_IN_SAMPLE * numberOfSamples;
-    header->riff.size = NUMBER_OF_BYTES_IN_SAMPLE * numberOfSamples + sizeof(WAV_header_t) - sizeof(chunk_t);
+    bufferFormat = newBufferFormat;
+
+    fileFormat = newFileFormat;
+
+    bufferBytesPerSample = bytesPerSample[bufferFormat];
+
+    fileBytesPerSample = bytesPerSample[fileFormat];
+
+    numberOfChannels = newNumberOfChannels;
+
+    bufferBytesPerFrame = bufferBytesPerSample * numberOfChannels;
+
+    fileBytesPerFrame = fileBytesPerSample * numberOfChannels;
+
+    headerSize = useExtensibleFormat() ? sizeof(WAV_header_t) : sizeof(WAV_header_t) - sizeof(wavFormatExtension_t);
 
 }
 
-void WavFile_setHeaderComment(WAV_header_t *header, int32_t currentTime, int32_t milliseconds, int32_t timeOffset, char *deviceName) {
+int32_t WavFile_getHeaderSize(void) {
 
-    struct tm time;
+    return headerSize;
 
-    time_t rawTime = currentTime;
+}
 
-    Time_gmTime(&rawTime, &time);
+int32_t WavFile_getBytesPerFrame(void) {
 
-    /* Format artist field */
+    return fileBytesPerFrame;
 
-    char *artist = header->iart.artist;
+}
 
-    sprintf(artist, "AudioMoth Live");
+/* Functions to convert between the header structure and the bytes in the file, which only include the format extension for wider samples or more than two channels */
 
-    /* Format comment field */
+static char *packHeaderOfSize(WAV_header_t *header, int32_t size) {
 
-    char *comment = header->icmt.comment;
+    static char bytes[sizeof(WAV_header_t)];
 
-    if (milliseconds < 0) {
+    size_t extensionOffset = offsetof(WAV_header_t, extension);
 
-        comment += sprintf(comment, "Recorded at %02d:%02d:%02d %02d/%02d/%04d (UTC", time.tm_hour, time.tm_min, time.tm_sec, time.tm_mday, MONTH_OFFSET + time.tm_mon, YEAR_OFFSET + time.tm_year);
+    size_t extensionLength = size - sizeof(WAV_header_t) + sizeof(wavFormatExtension_t);
 
-    } else {
+    memcpy(bytes, header, extensionOffset + extensionLength);
 
-        comment += sprintf(comment, "Recorded at %02d:%02d:%02d.%03d %02d/%02d/%04d (UTC", time.tm_hour, time.tm_min, time.tm_sec, milliseconds, time.tm_mday, MONTH_OFFSET + time.tm_mon, YEAR_OFFSET + time.tm_year);
+    memcpy(bytes + extensionOffset + extensionLength, &header->list, sizeof(WAV_header_t) - offsetof(WAV_header_t, list));
 
-    }
+    return bytes;
 
-    int32_t timeOffsetMinutes = timeOffset / SECONDS_IN_MINUTE;
+}
 
-    int32_t timezoneHours = timeOffsetMinutes / MINUTES_IN_HOUR;
+static bool unpackHeaderOfSize(char *bytes, WAV_header_t *header, int32_t size) {
 
-    int32_t timezoneMinutes = timeOffsetMinutes % MINUTES_IN_HOUR;
+    size_t extensionOffset = offsetof(WAV_header_t, extension);
 
-    if (timezoneHours < 0) {
+    size_t extensionLength = size - sizeof(WAV_header_t) + sizeof(wavFormatExtension_t);
 
-        comment += sprintf(comment, "%d", timezoneHours);
+    memset(header, 0, sizeof(WAV_header_t));
 
-    } else if (timezoneHours > 0) {
+    memcpy(header, bytes, extensionOffset + extensionLength);
 
-        comment += sprintf(comment, "+%d", timezoneHours);
+    memcpy(&header->list, bytes + extensionOffset + extensionLength, sizeof(WAV_header_t) - offsetof(WAV_header_t, list));
 
-    } else {
+    return header->fmt.size == sizeof(wavFormat_t) + extensionLength;
 
-        if (timezoneMinutes < 0) comment += sprintf(comment, "-0");
+}
 
-        if (timezoneMinutes > 0) comment += sprintf(comment, "+0");
+static char *packHeader(WAV_header_t *header) {
 
-    }
+    return packHeaderOfSize(header, headerSize);
 
-    if (timezoneMinutes < 0) comment += sprintf(comment, ":%02d", -timezoneMinutes);
+}
 
-    if (timezoneMinutes > 0) comment += sprintf(comment, ":%02d", timezoneMinutes);
+static bool unpackHeader(char *bytes, WAV_header_t *header) {
 
-    sprintf(comment, ") by %s using %s.", artist, deviceName);
+    return unpackHeaderOfSize(bytes, header, headerSize);
 
 }
 
-/* Function to generate file name */
+static bool readHeader(FILE *file, WAV_header_t *header) {
 
-void WavFile_setFilename(char *filename, int32_t currentTime, int32_t milliseconds, char *fileDestination) {
+    static char bytes[sizeof(WAV_header_t)];
 
-    struct tm time;
+    return fread(bytes, headerSize, 1, file) == 1 && unpackHeader(bytes, header);
 
-    time_t rawTime = currentTime;
+}
 
-    Time_gmTime(&rawTime, &time);
+static bool writeHeader(FILE *file, WAV_header_t *header) {
 
-    if (milliseconds < 0) {
+    return fwrite(packHeader(header), headerSize, 1, file) == 1;
 
-        sprintf(filename, "%s%s%04d%02d%02d_%02d%02d%02d.WAV", fileDestination, FILE_SEPARATOR, YEAR_OFFSET + time.tm_year, MONTH_OFFSET + time.tm_mon, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
+}
 
-    } else {
-    
-        sprintf(filename, "%s%s%04d%02d%02d_%02d%02d%02d_%03d.WAV", fileDestination, FILE_SEPARATOR, YEAR_OFFSET + time.tm_year, MONTH_OFFSET + time.tm_mon, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec, milliseconds);
+/* Functions to convert samples from the buffer format to the file format */
+
+static void convertFloatToIntegerGeneric(int32_t *destination, float *source, int32_t numberOfSamples, float scale, float maximum) {
+
+    for (int32_t i = 0; i < numberOfSamples; i += 1) {
+
+        float sample = MAX(-maximum - 1.0f, MIN(maximum, source[i] * scale));
+
+        destination[i] = (int32_t)lrintf(sample);
 
     }
 
 }
 
-/* Function to write file */
+#if IS_X86
 
-bool WavFile_writeFile(WAV_header_t *header, char *filename, int16_t *buffer1, int32_t numberOfSamples1, int16_t *buffer2, int32_t numberOfSamples2) {
+    CPU_TARGET("sse2") static void convertFloatToIntegerSSE2(int32_t *destination, float *source, int32_t numberOfSamples, float scale, float maximum) {
 
-    FILE *outputFile = fopen(filename, "w+b");
+        int32_t i = 0;
 
-    if (outputFile == NULL) return false;
+        __m128 scales = _mm_set1_ps(scale);
 
-    /* Write the header */
+        __m128 minimums = _mm_set1_ps(-maximum - 1.0f);
 
-    int32_t length = (int32_t)fwrite(header, sizeof(WAV_header_t), 1, outputFile);
+        __m128 maximums = _mm_set1_ps(maximum);
 
-    if (length != 1) return false;
+        for (; i + SSE_WIDTH <= numberOfSamples; i += SSE_WIDTH) {
 
-    /* Write the data */
+            __m128 samples = _mm_mul_ps(_mm_loadu_ps(source + i), scales);
+
+            samples = _mm_min_ps(_mm_max_ps(samples, minimums), maximums);
+
+            _mm_storeu_si128((__m128i*)(destination + i), _mm_cvtps_epi32(samples));
+
+        }
+
+        convertFloatToIntegerGeneric(destination + i, source + i, numberOfSamples - i, scale, maximum);
+
+    }
+
+    CPU_TARGET("avx2") static void convertFloatToIntegerAVX2(int32_t *destination, float *source, int32_t numberOfSamples, float scale, float maximum) {
+
+        int32_t i = 0;
+
+        __m256 scales = _mm256_set1_ps(scale);
 
-    length = (int32_t)fwrite(buffer1, NUMBER_OF_BYTES_IN_SAMPLE, numberOfSamples1, outputFile);
+        __m256 minimums = _mm256_set1_ps(-maximum - 1.0f);
 
-    if (length != numberOfSamples1) return false;
+        __m256 maximums = _mm256_set1_ps(maximum);
 
-    if (buffer2 != NULL) {
+        for (; i + AVX2_WIDTH <= numberOfSamples; i += AVX2_WIDTH) {
 
-        length = (int32_t)fwrite(buffer2, NUMBER_OF_BYTES_IN_SAMPLE, numberOfSamples2, outputFile);
+            __m256 samples = _mm256_mul_ps(_mm256_loadu_ps(source + i), scales);
 
-        if (length != numberOfSamples2) return false;
+            samples = _mm256_min_ps(_mm256_max_ps(samples, minimums), maximums);
+
+            _mm256_storeu_si256((__m256i*)(destination + i), _mm256_cvtps_epi32(samples));
+
+        }
+
+        convertFloatToIntegerGeneric(destination + i, source + i, numberOfSamples - i, scale, maximum);
 
     }
 
-    /* Close the file */
+    CPU_TARGET("avx512f") static void convertFloatToIntegerAVX512(int32_t *destination, float *source, int32_t numberOfSamples, float scale, float maximum) {
 
-    return fclose(outputFile) == 0;
+        int32_t i = 0;
+
+        __m512 scales = _mm512_set1_ps(scale);
+
+        __m512 minimums = _mm512_set1_ps(-maximum - 1.0f);
+
+        __m512 maximums = _mm512_set1_ps(maximum);
+
+        for (; i + AVX512_WIDTH <= numberOfSamples; i += AVX512_WIDTH) {
+
+            __m512 samples = _mm512_mul_ps(_mm512_loadu_ps(source + i), scales);
+
+            samples = _mm512_min_ps(_mm512_max_ps(samples, minimums), maximums);
+
+            _mm512_storeu_si512((void*)(destination + i), _mm512_cvtps_epi32(samples));
+
+        }
+
+        convertFloatToIntegerGeneric(destination + i, source + i, numberOfSamples - i, scale, maximum);
+
+    }
+
+#endif
+
+#if IS_ARM
+
+    CPU_NEON_TARGET static void convertFloatToIntegerNEON(int32_t *destination, float *source, int32_t numberOfSamples, float scale, float maximum) {
+
+        int32_t i = 0;
+
+        float32x4_t scales = vdupq_n_f32(scale);
+
+        float32x4_t minimums = vdupq_n_f32(-maximum - 1.0f);
+
+        float32x4_t maximums = vdupq_n_f32(maximum);
+
+        for (; i + NEON_WIDTH <= numberOfSamples; i += NEON_WIDTH) {
+
+            float32x4_t samples = vmulq_f32(vld1q_f32(source + i), scales);
+
+            samples = vminq_f32(vmaxq_f32(samples, minimums), maximums);
+
+            #if defined(__aarch64__)
+
+                vst1q_s32(destination + i, vcvtnq_s32_f32(samples));
+
+            #else
+
+                /* ARMv7 only converts by truncation so step away from zero when the remainder is over a half, or exactly a half and the result is odd, to match lrintf */
+
+                int32x4_t truncated = vcvtq_s32_f32(samples);
+
+                float32x4_t remainders = vabsq_f32(vsubq_f32(samples, vcvtq_f32_s32(truncated)));
+
+                uint32x4_t odd = vtstq_s32(truncated, vdupq_n_s32(1));
+
+                uint32x4_t step = vorrq_u32(vcgtq_f32(remainders, vdupq_n_f32(0.5f)), vandq_u32(vceqq_f32(remainders, vdupq_n_f32(0.5f)), odd));
+
+                int32x4_t signs = vbslq_s32(vcltq_f32(samples, vdupq_n_f32(0.0f)), vdupq_n_s32(-1), vdupq_n_s32(1));
+
+                vst1q_s32(destination + i, vaddq_s32(truncated, vandq_s32(signs, vreinterpretq_s32_u32(step))));
+
+            #endif
+
+        }
+
+        convertFloatToIntegerGeneric(destination + i, source + i, numberOfSamples - i, scale, maximum);
+
+    }
+
+#endif
+
+void WavFile_setInstructionSet(CPU_instructionSet_t instructionSet) {
+
+    convertFloatToInteger = convertFloatToIntegerGeneric;
+
+    #if IS_X86
+
+        if (instructionSet == CPU_SSE2) convertFloatToInteger = convertFloatToIntegerSSE2;
+
+        if (instructionSet == CPU_AVX2) convertFloatToInteger = convertFloatToIntegerAVX2;
+
+        if (instructionSet == CPU_AVX512) convertFloatToInteger = convertFloatToIntegerAVX512;
+
+    #endif
+
+    #if IS_ARM
+
+        if (instructionSet == CPU_NEON) convertFloatToInteger = convertFloatToIntegerNEON;
+
+    #endif
 
 }
 
-bool WavFile_appendFile(char *filename, int16_t *buffer1, int32_t numberOfSamples1, int16_t *buffer2, int32_t numberOfSamples2) {
+static void convertSamples(char *destination, char *source, int32_t numberOfSamples) {
 
-    static WAV_header_t header;
+    static int32_t integers[CONVERSION_BUFFER_SIZE];
 
-    if (access(filename, F_OK) != 0) return false;
+    if (bufferFormat == fileFormat) {
 
-    FILE *outputFile = fopen(filename, "r+b");
+        memcpy(destination, source, (size_t)bufferBytesPerSample * numberOfSamples);
 
-    if (outputFile == NULL) return false;
+        return;
 
-    /* Write the data */
+    }
 
-    fseek(outputFile, 0, SEEK_END);
+    int16_t *shorts = (int16_t*)source;
+
+    float *floats = (float*)source;
+
+    for (int32_t offset = 0; offset < numberOfSamples; offset += CONVERSION_BUFFER_SIZE) {
+
+        int32_t count = MIN(CONVERSION_BUFFER_SIZE, numberOfSamples - offset);
+
+        char *output = destination + (size_t)fileBytesPerSample * offset;
+
+        if (bufferFormat == WAV_INT16) {
 
-    int32_t length = (int32_t)fwrite(buffer1, NUMBER_OF_BYTES_IN_SAMPLE, numberOfSamples1, outputFile);
+            for (int32_t i = 0; i < count; i += 1) {
 
-    if (length != numberOfSamples1) return false;
+                if (fileFormat == WAV_FLOAT32) ((float*)output)[i] = shorts[offset + i] / INT16_SCALE;
 
-    if (buffer2 != NULL) {
+                if (fileFormat == WAV_INT24) integers[i] = (int32_t)shorts[offset + i] << BITS_IN_BYTE;
 
-        length = (int32_t)fwrite(buffer2, NUMBER_OF_BYTES_IN_SAMPLE, numberOfSamples2, outputFile);
+            }
 
-        if (length != numberOfSamples2) return false;
+            if (fileFormat == WAV_FLOAT32) continue;
+
+        } else {
+
+            convertFloatToInteger(integers, floats + offset, count, fileFormat == WAV_INT16 ? INT16_SCALE : INT24_SCALE, fileFormat == WAV_INT16 ? INT16_SCALE - 1.0f : INT24_SCALE - 1.0f);
+
+        }
+
+        /* Pack the integers as little endian samples of the file width */
+
+        if (fileFormat == WAV_INT16) {
+
+            for (int32_t i = 0; i < count; i += 1) ((int16_t*)output)[i] = (int16_t)integers[i];
+
+        } else {
+
+            for (int32_t i = 0; i < count; i += 1) {
+
+                output[3 * i] = (char)integers[i];
+                output[3 * i + 1] = (char)(integers[i] >> BITS_IN_BYTE);
+                output[3 * i + 2] = (char)(integers[i] >> (2 * BITS_IN_BYTE));
+
+            }
+
+        }
 
     }
 
-    /* Rewind to the start and load the header */
+}
 
-    fseek(outputFile, 0, SEEK_SET);
+static bool writeSamples(FILE *file, void *buffer, int32_t numberOfFrames) {
 
-    length = (int32_t)fread(&header, sizeof(WAV_header_t), 1, outputFile);
+    static char convertedSamples[CONVERSION_BUFFER_SIZE * sizeof(float)];
 
-    if (length != 1) return false;
+    if (bufferFormat == fileFormat) return (int32_t)fwrite(buffer, bufferBytesPerFrame, numberOfFrames, file) == numberOfFrames;
 
-    /* Update the header */
+    int32_t numberOfSamples = numberOfFrames * numberOfChannels;
 
-    int32_t numberOfSamples = numberOfSamples1;
+    char *source = (char*)buffer;
 
-    if (buffer2 != NULL) numberOfSamples += numberOfSamples2;
+    for (int32_t offset = 0; offset < numberOfSamples; offset += CONVERSION_BUFFER_SIZE) {
 
-    header.data.size += NUMBER_OF_BYTES_IN_SAMPLE * numberOfSamples;
-    header.riff.size += NUMBER_OF_BYTES_IN_SAMPLE * numberOfSamples;
+        int32_t count = MIN(CONVERSION_BUFFER_SIZE, numberOfSamples - offset);
 
-    /* Write the header */
+        convertSamples(convertedSamples, source + (size_t)bufferBytesPerSample * offset, count);
 
-    fseek(outputFile, 0, SEEK_SET);
+        if ((int32_t)fwrite(convertedSamples, fileBytesPerSample, count, file) != count) return false;
 
-    length = (int32_t)fwrite(&header, sizeof(WAV_header_t), 1, outputFile);
+    }
 
-    if (length != 1) return false;
+    return true;
 
-    /* Close the file */
+}
 
-    return fclose(outputFile) == 0;
+/* Functions to set WAV header details and comment */
+
+void WavFile_initialiseHeader(WAV_header_t *header) {
+
+    memcpy(header, &defaultHeader, sizeof(WAV_header_t));
+
+    header->wavFormat.numberOfChannels = numberOfChannels;
+    header->wavFormat.bytesPerCapture = fileBytesPerFrame;
+
+    if (useExtensibleFormat() == false) return;
+
+    /* Wider samples and more than two channels use the extensible format */
+
+    header->fmt.size = sizeof(wavFormat_t) + sizeof(wavFormatExtension_t);
+
+    header->wavFormat.format = EXTENSIBLE_FORMAT;
+    header->wavFormat.bitsPerSample = BITS_IN_BYTE * fileBytesPerSample;
+
+    header->extension.size = sizeof(wavFormatExtension_t) - sizeof(uint16_t);
+    header->extension.validBitsPerSample = BITS_IN_BYTE * fileBytesPerSample;
+    header->extension.channelMask = numberOfChannels == 1 ? FRONT_CENTRE_CHANNEL_MASK : numberOfChannels == 4 ? QUADRAPHONIC_CHANNEL_MASK : (1 << numberOfChannels) - 1;
+
+    memcpy(header->extension.subFormat, fileFormat == WAV_FLOAT32 ? floatSubFormat : pcmSubFormat, LENGTH_OF_GUID);
+
+}
+
+void WavFile_setHeaderDetails(WAV_header_t *header, uint32_t sampleRate, uint32_t numberOfSamples) {
+
+    header->wavFormat.samplesPerSecond = sampleRate;
+    header->wavFormat.bytesPerSecond = fileBytesPerFrame * sampleRate;
+    header->data.size = fileBytesPerFrame * numberOfSamples;
+    header->riff.size = fileBytesPerFrame * numberOfSamples + headerSize - sizeof(chunk_t);
+
+}
+
+void WavFile_setHeaderComment(WAV_header_t *header, int32_t currentTime, int32_t milliseconds, int32_t timeOffset, char *deviceName) {
+
+    struct tm time;
+
+    time_t rawTime = currentTime;
+
+    Time_gmTime(&rawTime, &time);
+
+    /* Format artist field */
+
+    char *artist = header->iart.artist;
+
+    sprintf(artist, "AudioMoth Live");
+
+    /* Format comment field */
+
+    char *comment = header->icmt.comment;
+
+    if (milliseconds < 0) {
+
+        comment += sprintf(comment, "Recorded at %02d:%02d:%02d %02d/%02d/%04d (UTC", time.tm_hour, time.tm_min, time.tm_sec, time.tm_mday, MONTH_OFFSET + time.tm_mon, YEAR_OFFSET + time.tm_year);
+
+    } else {
+
+        comment += sprintf(comment, "Recorded at %02d:%02d:%02d.%03d %02d/%02d/%04d (UTC", time.tm_hour, time.tm_min, time.tm_sec, milliseconds, time.tm_mday, MONTH_OFFSET + time.tm_mon, YEAR_OFFSET + time.tm_year);
+
+    }
+
+    int32_t timeOffsetMinutes = timeOffset / SECONDS_IN_MINUTE;
+
+    int32_t timezoneHours = timeOffsetMinutes / MINUTES_IN_HOUR;
+
+    int32_t timezoneMinutes = timeOffsetMinutes % MINUTES_IN_HOUR;
+
+    if (timezoneHours < 0) {
+
+        comment += sprintf(comment, "%d", timezoneHours);
+
+    } else if (timezoneHours > 0) {
+
+        comment += sprintf(comment, "+%d", timezoneHours);
+
+    } else {
+
+        if (timezoneMinutes < 0) comment += sprintf(comment, "-0");
+
+        if (timezoneMinutes > 0) comment += sprintf(comment, "+0");
+
+    }
+
+    if (timezoneMinutes < 0) comment += sprintf(comment, ":%02d", -timezoneMinutes);
+
+    if (timezoneMinutes > 0) comment += sprintf(comment, ":%02d", timezoneMinutes);
+
+    sprintf(comment, ") by %s using %s.", artist, deviceName);
+
+}
+
+/* Function to add the measured levels to the comment */
+
+void WavFile_addHeaderLevels(WAV_header_t *header, double peakLevel, double rmsLevel, int64_t clippedSamples) {
+
+    char *comment = header->icmt.comment;
+
+    size_t length = strlen(comment);
+
+    snprintf(comment + length, LENGTH_OF_COMMENT - length, " Peak level was %.1f dBFS with an RMS level of %.1f dBFS and %lld clipped samples.", peakLevel, rmsLevel, (long long)clippedSamples);
+
+}
+
+/* Function to replace the comment when a file is appended */
+
+static void replaceComment(WAV_header_t *header, char *comment) {
+
+    memset(header->icmt.comment, 0, LENGTH_OF_COMMENT);
+
+    strncpy(header->icmt.comment, comment, LENGTH_OF_COMMENT - 1);
+
+}
+
+/* Function to generate file name */
+
+void WavFile_setFilename(char *filename, int32_t currentTime, int32_t milliseconds, char *fileDestination, WAV_directoryLayout_t layout) {
+
+    struct tm time;
+
+    time_t rawTime = currentTime;
+
+    Time_gmTime(&rawTime, &time);
+
+    /* Add date partitioned directories to the destination */
+
+    static char directory[FILE_DESTINATION_BUFFER_SIZE];
+
+    if (layout == WAV_DAILY_LAYOUT) {
+
+        snprintf(directory, FILE_DESTINATION_BUFFER_SIZE, "%s%s%04d%s%02d%s%02d", fileDestination, FILE_SEPARATOR, YEAR_OFFSET + time.tm_year, FILE_SEPARATOR, MONTH_OFFSET + time.tm_mon, FILE_SEPARATOR, time.tm_mday);
+
+        fileDestination = directory;
+
+    } else if (layout == WAV_HOURLY_LAYOUT) {
+
+        snprintf(directory, FILE_DESTINATION_BUFFER_SIZE, "%s%s%04d%s%02d%s%02d%s%02d", fileDestination, FILE_SEPARATOR, YEAR_OFFSET + time.tm_year, FILE_SEPARATOR, MONTH_OFFSET + time.tm_mon, FILE_SEPARATOR, time.tm_mday, FILE_SEPARATOR, time.tm_hour);
+
+        fileDestination = directory;
+
+    }
+
+    if (milliseconds < 0) {
+
+        sprintf(filename, "%s%s%04d%02d%02d_%02d%02d%02d.WAV", fileDestination, FILE_SEPARATOR, YEAR_OFFSET + time.tm_year, MONTH_OFFSET + time.tm_mon, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec);
+
+    } else {
+    
+        sprintf(filename, "%s%s%04d%02d%02d_%02d%02d%02d_%03d.WAV", fileDestination, FILE_SEPARATOR, YEAR_OFFSET + time.tm_year, MONTH_OFFSET + time.tm_mon, time.tm_mday, time.tm_hour, time.tm_min, time.tm_sec, milliseconds);
+
+    }
+
+}
+
+/* Function to reserve space beyond the end of the file without changing its size */
+
+static bool preallocateFile(FILE *file, int64_t size) {
+
+    #if defined(_WIN32) || defined(_WIN64)
+
+        FILE_ALLOCATION_INFO information;
+
+        information.AllocationSize.QuadPart = size;
+
+        return SetFileInformationByHandle((HANDLE)_get_osfhandle(_fileno(file)), FileAllocationInfo, &information, sizeof(FILE_ALLOCATION_INFO)) != 0;
+
+    #elif defined(__APPLE__)
+
+        fstore_t store = {F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, size, 0};
+
+        if (fcntl(fileno(file), F_PREALLOCATE, &store) == -1) {
+
+            store.fst_flags = F_ALLOCATEALL;
+
+            return fcntl(fileno(file), F_PREALLOCATE, &store) != -1;
+
+        }
+
+        return true;
+
+    #elif defined(__linux__)
+
+        return fallocate(fileno(file), FALLOC_FL_KEEP_SIZE, 0, size) == 0;
+
+    #else
+
+        return false;
+
+    #endif
+
+}
+
+/* Functions to make written data durable */
+
+void WavFile_setDurability(WAV_durability_t durability, int32_t interval) {
+
+    durabilityPolicy = durability;
+
+    durabilityInterval = interval;
+
+}
+
+static bool shouldSync(void) {
+
+    if (durabilityPolicy == WAV_SYNC_APPEND) return true;
+
+    if (durabilityPolicy == WAV_SYNC_INTERVAL) {
+
+        time_t currentTime = time(NULL);
+
+        if (currentTime - previousSyncTime >= durabilityInterval) {
+
+            previousSyncTime = currentTime;
+
+            return true;
+
+        }
+
+    }
+
+    return false;
+
+}
+
+static bool syncFile(FILE *file) {
+
+    if (fflush(file) != 0) return false;
+
+    #if defined(_WIN32) || defined(_WIN64)
+
+        return _commit(_fileno(file)) == 0;
+
+    #elif defined(__APPLE__)
+
+        return fsync(fileno(file)) == 0;
+
+    #else
+
+        return fdatasync(fileno(file)) == 0;
+
+    #endif
+
+}
+
+/* Functions to copy samples straight from the buffer into a mapping of the file */
+
+void WavFile_setWriter(WAV_writer_t writer) {
+
+    #if defined(_WIN32) || defined(_WIN64)
+
+        writerMode = WAV_STDIO_WRITER;
+
+    #else
+
+        writerMode = writer;
+
+    #endif
+
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    static bool copyToMapping(FILE *file, WAV_header_t *emptyHeader, WAV_header_t *header, int64_t offset, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2, bool sync) {
+
+        return false;
+
+    }
+
+#else
+
+    static bool copyToMapping(FILE *file, WAV_header_t *emptyHeader, WAV_header_t *header, int64_t offset, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2, bool sync) {
+
+        int descriptor = fileno(file);
+
+        int64_t length1 = (int64_t)fileBytesPerFrame * numberOfSamples1;
+
+        int64_t length2 = buffer2 == NULL ? 0 : (int64_t)fileBytesPerFrame * numberOfSamples2;
+
+        int64_t end = offset + length1 + length2;
+
+        /* Reserve the blocks and then extend the file as writing to a mapping beyond the end of the file raises SIGBUS */
+
+        struct stat status;
+
+        if (fstat(descriptor, &status) != 0) return false;
+
+        if (end > status.st_size) {
+
+            bool reserved = preallocateFile(file, end);
+
+            #if defined(__linux__)
+
+                /* File systems such as exFAT and FAT cannot reserve without extending so allocate the new range directly */
+
+                if (reserved == false && errno == EOPNOTSUPP) reserved = posix_fallocate(descriptor, status.st_size, end - status.st_size) == 0;
+
+            #endif
+
+            if (reserved == false) return false;
+
+            if (ftruncate(descriptor, end) != 0) return false;
+
+        }
+
+        /* Write the placeholder header ahead of the samples so a crash leaves a readable file */
+
+        if (emptyHeader != NULL && pwrite(descriptor, packHeader(emptyHeader), headerSize, 0) != headerSize) return false;
+
+        /* Map only the pages holding the new samples */
+
+        int64_t pageSize = sysconf(_SC_PAGESIZE);
+
+        int64_t dataStart = offset - offset % pageSize;
+
+        size_t mappingLength = (size_t)(end - dataStart);
+
+        bool success = true;
+
+        if (mappingLength > 0) {
+
+            char *mapping = mmap(NULL, mappingLength, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, (off_t)dataStart);
+
+            if (mapping == MAP_FAILED) return false;
+
+            madvise(mapping, mappingLength, MADV_SEQUENTIAL);
+
+            convertSamples(mapping + offset - dataStart, buffer1, numberOfSamples1 * numberOfChannels);
+
+            if (buffer2 != NULL) convertSamples(mapping + offset - dataStart + length1, buffer2, numberOfSamples2 * numberOfChannels);
+
+            /* Wait for the samples before writing the complete header when syncing, otherwise just start write back */
+
+            success = msync(mapping, mappingLength, sync ? MS_SYNC : MS_ASYNC) == 0;
+
+            success = munmap(mapping, mappingLength) == 0 && success;
+
+        }
+
+        success = success && pwrite(descriptor, packHeader(header), headerSize, 0) == headerSize;
+
+        if (sync) success = success && syncFile(file);
+
+        return success;
+
+    }
+
+#endif
+
+static bool writeMappedFile(FILE *outputFile, WAV_header_t *header, WAV_header_t *emptyHeader, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2, bool sync) {
+
+    bool success = copyToMapping(outputFile, sync ? emptyHeader : NULL, header, headerSize, buffer1, numberOfSamples1, buffer2, numberOfSamples2, sync);
+
+    return fclose(outputFile) == 0 && success;
+
+}
+
+static bool appendMappedFile(FILE *outputFile, char *comment, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2) {
+
+    static WAV_header_t header;
+
+    if (readHeader(outputFile, &header) == false) {
+
+        fclose(outputFile);
+
+        return false;
+
+    }
+
+    /* Copy the data after the samples described by the header and then update the header in place */
+
+    int64_t offset = headerSize + (int64_t)header.data.size;
+
+    int64_t length1 = (int64_t)fileBytesPerFrame * numberOfSamples1;
+
+    int64_t length2 = buffer2 == NULL ? 0 : (int64_t)fileBytesPerFrame * numberOfSamples2;
+
+    header.data.size += (uint32_t)(length1 + length2);
+    header.riff.size += (uint32_t)(length1 + length2);
+
+    if (comment != NULL) replaceComment(&header, comment);
+
+    bool success = copyToMapping(outputFile, NULL, &header, offset, buffer1, numberOfSamples1, buffer2, numberOfSamples2, shouldSync());
+
+    return fclose(outputFile) == 0 && success;
+
+}
+
+/* Functions to write through aligned staging buffers which bypass the page cache */
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    static bool writeDirectFile(FILE *outputFile, char *filename, WAV_header_t *header, WAV_header_t *emptyHeader, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2, bool sync) {
+
+        fclose(outputFile);
+
+        return false;
+
+    }
+
+    static bool appendDirectFile(FILE *outputFile, char *filename, char *comment, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2) {
+
+        fclose(outputFile);
+
+        return false;
+
+    }
+
+#else
+
+    static bool allocateDirectBuffers(void) {
+
+        if (directFile.staging != NULL) return true;
+
+        void *memory;
+
+        if (posix_memalign(&memory, DIRECT_BLOCK_SIZE, DIRECT_STAGING_SIZE + 2 * DIRECT_BLOCK_SIZE) != 0) return false;
+
+        directFile.staging = (char*)memory;
+
+        directFile.headBlock = directFile.staging + DIRECT_STAGING_SIZE;
+
+        directFile.tailBlock = directFile.headBlock + DIRECT_BLOCK_SIZE;
+
+        return true;
+
+    }
+
+    static void enableDirectIO(int descriptor) {
+
+        /* File systems without direct I/O fall back to cached writes of the same aligned blocks */
+
+        #if defined(__linux__)
+
+            int flags = fcntl(descriptor, F_GETFL);
+
+            if (flags >= 0) fcntl(descriptor, F_SETFL, flags | O_DIRECT);
+
+        #elif defined(__APPLE__)
+
+            fcntl(descriptor, F_NOCACHE, 1);
+
+        #endif
+
+    }
+
+    static bool flushStaging(int descriptor, int64_t position, int64_t length) {
+
+        if (position == 0) memcpy(directFile.headBlock, directFile.staging, DIRECT_BLOCK_SIZE);
+
+        return pwrite(descriptor, directFile.staging, length, position) == length;
+
+    }
+
+    static bool writeDirect(int descriptor, void *buffer1, int64_t length1, void *buffer2, int64_t length2) {
+
+        /* Start the staging buffer with the unaligned tail kept from the previous write */
+
+        int64_t position = directFile.length - directFile.length % DIRECT_BLOCK_SIZE;
+
+        int64_t used = directFile.length - position;
+
+        memcpy(directFile.staging, directFile.tailBlock, used);
+
+        char *sources[2] = {(char*)buffer1, (char*)buffer2};
+
+        int64_t lengths[2] = {length1, buffer2 == NULL ? 0 : length2};
+
+        for (int32_t i = 0; i < 2; i += 1) {
+
+            char *source = sources[i];
+
+            int64_t remaining = lengths[i];
+
+            while (remaining > 0) {
+
+                int64_t length = MIN(remaining, DIRECT_STAGING_SIZE - used);
+
+                memcpy(directFile.staging + used, source, length);
+
+                used += length;
+
+                source += length;
+
+                remaining -= length;
+
+                if (used == DIRECT_STAGING_SIZE) {
+
+                    if (flushStaging(descriptor, position, DIRECT_STAGING_SIZE) == false) return false;
+
+                    position += DIRECT_STAGING_SIZE;
+
+                    used = 0;
+
+                }
+
+            }
+
+        }
+
+        /* Pad the final block with zeros and keep its unaligned part for the next write */
+
+        if (used > 0) {
+
+            int64_t padded = used + (DIRECT_BLOCK_SIZE - used % DIRECT_BLOCK_SIZE) % DIRECT_BLOCK_SIZE;
+
+            memset(directFile.staging + used, 0, padded - used);
+
+            if (flushStaging(descriptor, position, padded) == false) return false;
+
+            memcpy(directFile.tailBlock, directFile.staging + padded - DIRECT_BLOCK_SIZE, DIRECT_BLOCK_SIZE);
+
+        }
+
+        directFile.length += lengths[0] + lengths[1];
+
+        return true;
+
+    }
+
+    static bool writeDirectSamples(int descriptor, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2) {
+
+        static char convertedSamples[CONVERSION_BUFFER_SIZE * sizeof(float)];
+
+        if (bufferFormat == fileFormat) return writeDirect(descriptor, buffer1, (int64_t)bufferBytesPerFrame * numberOfSamples1, buffer2, (int64_t)bufferBytesPerFrame * numberOfSamples2);
+
+        /* Convert in chunks which are then staged as bytes */
+
+        char *sources[2] = {(char*)buffer1, (char*)buffer2};
+
+        int32_t counts[2] = {numberOfSamples1 * numberOfChannels, buffer2 == NULL ? 0 : numberOfSamples2 * numberOfChannels};
+
+        for (int32_t i = 0; i < 2; i += 1) {
+
+            for (int32_t offset = 0; offset < counts[i]; offset += CONVERSION_BUFFER_SIZE) {
+
+                int32_t count = MIN(CONVERSION_BUFFER_SIZE, counts[i] - offset);
+
+                convertSamples(convertedSamples, sources[i] + (size_t)bufferBytesPerSample * offset, count);
+
+                if (writeDirect(descriptor, convertedSamples, (int64_t)fileBytesPerSample * count, NULL, 0) == false) return false;
+
+            }
+
+        }
+
+        return true;
+
+    }
+
+    static bool writeDirectHeader(int descriptor, WAV_header_t *header) {
+
+        char *bytes = packHeader(header);
+
+        memcpy(directFile.headBlock, bytes, headerSize);
+
+        if (directFile.length < DIRECT_BLOCK_SIZE) memcpy(directFile.tailBlock, bytes, headerSize);
+
+        return pwrite(descriptor, directFile.headBlock, DIRECT_BLOCK_SIZE, 0) == DIRECT_BLOCK_SIZE;
+
+    }
+
+    static bool loadDirectBlocks(int descriptor, char *filename) {
+
+        /* Read the first and last blocks of a file which was not written by the previous call */
+
+        memset(directFile.headBlock, 0, DIRECT_BLOCK_SIZE);
+
+        static WAV_header_t header;
+
+        if (pread(descriptor, directFile.headBlock, DIRECT_BLOCK_SIZE, 0) < headerSize || unpackHeader(directFile.headBlock, &header) == false) return false;
+
+        directFile.length = headerSize + (int64_t)header.data.size;
+
+        memset(directFile.tailBlock, 0, DIRECT_BLOCK_SIZE);
+
+        if (pread(descriptor, directFile.tailBlock, DIRECT_BLOCK_SIZE, directFile.length - directFile.length % DIRECT_BLOCK_SIZE) < 0) return false;
+
+        strncpy(directFile.filename, filename, FILE_DESTINATION_BUFFER_SIZE - 1);
+
+        return true;
+
+    }
+
+    static bool writeDirectFile(FILE *outputFile, char *filename, WAV_header_t *header, WAV_header_t *emptyHeader, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2, bool sync) {
+
+        int descriptor = fileno(outputFile);
+
+        if (allocateDirectBuffers() == false) {
+
+            fclose(outputFile);
+
+            return false;
+
+        }
+
+        enableDirectIO(descriptor);
+
+        strncpy(directFile.filename, filename, FILE_DESTINATION_BUFFER_SIZE - 1);
+
+        directFile.length = 0;
+
+        /* Write the header and data as one aligned stream, filling in the sizes after the data is durable if syncing */
+
+        bool success = writeDirect(descriptor, packHeader(sync ? emptyHeader : header), headerSize, NULL, 0);
+
+        success = success && writeDirectSamples(descriptor, buffer1, numberOfSamples1, buffer2, numberOfSamples2);
+
+        if (sync) {
+
+            success = success && syncFile(outputFile) && writeDirectHeader(descriptor, header) && syncFile(outputFile);
+
+        }
+
+        if (success == false) directFile.filename[0] = 0;
+
+        return fclose(outputFile) == 0 && success;
+
+    }
+
+    static bool appendDirectFile(FILE *outputFile, char *filename, char *comment, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2) {
+
+        int descriptor = fileno(outputFile);
+
+        if (allocateDirectBuffers() == false) {
+
+            fclose(outputFile);
+
+            return false;
+
+        }
+
+        enableDirectIO(descriptor);
+
+        bool success = strcmp(directFile.filename, filename) == 0 || loadDirectBlocks(descriptor, filename);
+
+        /* Write the data and then update the header held in the first block */
+
+        int64_t length1 = (int64_t)fileBytesPerFrame * numberOfSamples1;
+
+        int64_t length2 = buffer2 == NULL ? 0 : (int64_t)fileBytesPerFrame * numberOfSamples2;
+
+        bool sync = shouldSync();
+
+        success = success && writeDirectSamples(descriptor, buffer1, numberOfSamples1, buffer2, numberOfSamples2);
+
+        if (sync) success = success && syncFile(outputFile);
+
+        static WAV_header_t header;
+
+        success = success && unpackHeader(directFile.headBlock, &header);
+
+        header.data.size += (uint32_t)(length1 + length2);
+        header.riff.size += (uint32_t)(length1 + length2);
+
+        if (comment != NULL) replaceComment(&header, comment);
+
+        success = success && writeDirectHeader(descriptor, &header);
+
+        if (sync) success = success && syncFile(outputFile);
+
+        if (success == false) directFile.filename[0] = 0;
+
+        return fclose(outputFile) == 0 && success;
+
+    }
+
+#endif
+
+/* Function to drop written pages from the page cache once they have been written back */
+
+static void dropCachedPages(FILE *file) {
+
+    #if defined(__linux__)
+
+        fflush(file);
+
+        posix_fadvise(fileno(file), 0, 0, POSIX_FADV_DONTNEED);
+
+    #endif
+
+}
+
+/* Function to write file */
+
+bool WavFile_writeFile(WAV_header_t *header, char *filename, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2, int32_t numberOfSamplesToPreallocate) {
+
+    FILE *outputFile = Directory_openFile(filename, "w+b");
+
+    if (outputFile == NULL) return false;
+
+    /* Reserve space for the final file so that later appends are contiguous */
+
+    if (numberOfSamplesToPreallocate > 0) preallocateFile(outputFile, headerSize + (int64_t)fileBytesPerFrame * numberOfSamplesToPreallocate);
+
+    /* Write the header, leaving the sizes empty until the data is durable if syncing */
+
+    static WAV_header_t emptyHeader;
+
+    bool sync = shouldSync();
+
+    if (sync) {
+
+        memcpy(&emptyHeader, header, sizeof(WAV_header_t));
+
+        emptyHeader.data.size = 0;
+        emptyHeader.riff.size = headerSize - sizeof(chunk_t);
+
+    }
+
+    if (writerMode == WAV_MAPPED_WRITER) return writeMappedFile(outputFile, header, &emptyHeader, buffer1, numberOfSamples1, buffer2, numberOfSamples2, sync);
+
+    if (writerMode == WAV_DIRECT_WRITER) return writeDirectFile(outputFile, filename, header, &emptyHeader, buffer1, numberOfSamples1, buffer2, numberOfSamples2, sync);
+
+    if (writeHeader(outputFile, sync ? &emptyHeader : header) == false) return false;
+
+    /* Write the data */
+
+    if (writeSamples(outputFile, buffer1, numberOfSamples1) == false) return false;
+
+    if (buffer2 != NULL && writeSamples(outputFile, buffer2, numberOfSamples2) == false) return false;
+
+    /* Sync the data and then write and sync the complete header */
+
+    if (sync) {
+
+        if (syncFile(outputFile) == false) return false;
+
+        fseek(outputFile, 0, SEEK_SET);
+
+        if (writeHeader(outputFile, header) == false) return false;
+
+        if (syncFile(outputFile) == false) return false;
+
+    }
+
+    /* Close the file */
+
+    if (writerMode == WAV_DONTNEED_WRITER) dropCachedPages(outputFile);
+
+    return fclose(outputFile) == 0;
+
+}
+
+bool WavFile_appendFile(char *filename, char *comment, void *buffer1, int32_t numberOfSamples1, void *buffer2, int32_t numberOfSamples2) {
+
+    static WAV_header_t header;
+
+    FILE *outputFile = Directory_openFile(filename, "r+b");
+
+    if (outputFile == NULL) return false;
+
+    if (writerMode == WAV_MAPPED_WRITER) return appendMappedFile(outputFile, comment, buffer1, numberOfSamples1, buffer2, numberOfSamples2);
+
+    if (writerMode == WAV_DIRECT_WRITER) return appendDirectFile(outputFile, filename, comment, buffer1, numberOfSamples1, buffer2, numberOfSamples2);
+
+    /* Write the data */
+
+    fseek(outputFile, 0, SEEK_END);
+
+    if (writeSamples(outputFile, buffer1, numberOfSamples1) == false) return false;
+
+    if (buffer2 != NULL && writeSamples(outputFile, buffer2, numberOfSamples2) == false) return false;
+
+    /* Sync the data before the header so the header never describes data that was lost */
+
+    bool sync = shouldSync();
+
+    if (sync && syncFile(outputFile) == false) return false;
+
+    /* Rewind to the start and load the header */
+
+    fseek(outputFile, 0, SEEK_SET);
+
+    if (readHeader(outputFile, &header) == false) return false;
+
+    /* Update the header */
+
+    int32_t numberOfSamples = numberOfSamples1;
+
+    if (buffer2 != NULL) numberOfSamples += numberOfSamples2;
+
+    header.data.size += fileBytesPerFrame * numberOfSamples;
+    header.riff.size += fileBytesPerFrame * numberOfSamples;
+
+    if (comment != NULL) replaceComment(&header, comment);
+
+    /* Write the header */
+
+    fseek(outputFile, 0, SEEK_SET);
+
+    if (writeHeader(outputFile, &header) == false) return false;
+
+    if (sync && syncFile(outputFile) == false) return false;
+
+    /* Close the file */
+
+    if (writerMode == WAV_DONTNEED_WRITER) dropCachedPages(outputFile);
+
+    return fclose(outputFile) == 0;
+
+}
+
+/* Function to release space reserved beyond the data */
+
+bool WavFile_releaseFile(char *filename) {
+
+    static WAV_header_t header;
+
+    FILE *outputFile = Directory_openFile(filename, "r+b");
+
+    if (outputFile == NULL) return false;
+
+    if (readHeader(outputFile, &header) == false) {
+
+        fclose(outputFile);
+
+        return false;
+
+    }
+
+    int64_t size = headerSize + (int64_t)header.data.size;
+
+    #if defined(_WIN32) || defined(_WIN64)
+
+        bool success = _chsize_s(_fileno(outputFile), size) == 0;
+
+    #else
+
+        bool success = ftruncate(fileno(outputFile), size) == 0;
+
+    #endif
+
+    return fclose(outputFile) == 0 && success;
+
+}
+
+/* Function to repair the header of a file which was interrupted by a crash */
+
+bool WavFile_repairFile(char *filename, int64_t length, bool *repaired) {
+
+    static WAV_header_t header;
+
+    *repaired = false;
+
+    FILE *outputFile = Directory_openFile(filename, "r+b");
+
+    if (outputFile == NULL) return false;
+
+    /* Take the header size and frame size from the file itself as recovery runs before the sample format is selected */
+
+    static char bytes[sizeof(WAV_header_t)];
+
+    size_t count = fread(bytes, 1, sizeof(WAV_header_t), outputFile);
+
+    uint32_t formatSize = 0;
+
+    if (count >= offsetof(WAV_header_t, wavFormat)) memcpy(&formatSize, bytes + offsetof(WAV_header_t, fmt.size), sizeof(uint32_t));
+
+    int32_t fileHeaderSize = formatSize == sizeof(wavFormat_t) + sizeof(wavFormatExtension_t) ? sizeof(WAV_header_t) : sizeof(WAV_header_t) - sizeof(wavFormatExtension_t);
+
+    bool valid = count >= (size_t)fileHeaderSize && unpackHeaderOfSize(bytes, &header, fileHeaderSize) && memcmp(header.riff.id, "RIFF", RIFF_ID_LENGTH) == 0 && memcmp(header.format, "WAVE", RIFF_ID_LENGTH) == 0 && memcmp(header.data.id, "data", RIFF_ID_LENGTH) == 0 && header.wavFormat.bytesPerCapture > 0;
+
+    if (valid == false) {
+
+        fclose(outputFile);
+
+        return false;
+
+    }
+
+    /* Use the whole samples actually present in the file */
+
+    fseek(outputFile, 0, SEEK_END);
+
+    int64_t fileLength = ftell(outputFile);
+
+    /* Ignore anything beyond the recorded length, such as the padding of the last direct I/O block */
+
+    if (length >= fileHeaderSize) fileLength = MIN(fileLength, length);
+
+    int64_t dataSize = fileLength - fileHeaderSize;
+
+    dataSize -= dataSize % header.wavFormat.bytesPerCapture;
+
+    if (dataSize != header.data.size) {
+
+        header.data.size = (uint32_t)dataSize;
+        header.riff.size = (uint32_t)dataSize + fileHeaderSize - sizeof(chunk_t);
+
+        fseek(outputFile, 0, SEEK_SET);
+
+        if (fwrite(packHeaderOfSize(&header, fileHeaderSize), fileHeaderSize, 1, outputFile) != 1 || syncFile(outputFile) == false) {
+
+            fclose(outputFile);
+
+            return false;
+
+        }
+
+        *repaired = true;
+
+    }
+
+    /* Remove any partial sample and release any space reserved beyond the data */
+
+    int64_t size = fileHeaderSize + dataSize;
+
+    #if defined(_WIN32) || defined(_WIN64)
+
+        bool truncated = _chsize_s(_fileno(outputFile), size) == 0;
+
+    #else
+
+        bool truncated = ftruncate(fileno(outputFile), size) == 0;
+
+    #endif
+
+    return fclose(outputFile) == 0 && truncated;
 
 }
@@ -4,11 +4,18 @@
  * March 2023
  *****************************************************************************/
 
+#include <string.h>
+
 #include "xdirectory.h"
 
+/* Path constant */
+
+#define PATH_BUFFER_SIZE    8192
+
 #if defined(_WIN32) || defined(_WIN64)
 
     #include <io.h>
+    #include <direct.h>
     #include <sys/types.h>
     #include <sys/stat.h>
     
@@ -27,17 +34,209 @@
 
     }
 
+    FILE *Directory_openFile(const char *path, const char *mode) {
+
+        static char directory[PATH_BUFFER_SIZE];
+
+        strncpy(directory, path, PATH_BUFFER_SIZE - 1);
+
+        /* Create any missing directories before opening the file */
+
+        for (char *separator = strchr(directory + 1, '\\'); separator != NULL; separator = strchr(separator + 1, '\\')) {
+
+            *separator = 0;
+
+            if (separator[-1] != ':') _mkdir(directory);
+
+            *separator = '\\';
+
+        }
+
+        return fopen(path, mode);
+
+    }
+
 #else
 
+    #include <errno.h>
+    #include <fcntl.h>
     #include <dirent.h>
+    #include <stdint.h>
     #include <stdlib.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+
+    /* Directory handle cache constants */
+
+    #define DIRECTORY_CACHE_SIZE    4
+
+    #define DIRECTORY_PERMISSIONS   (S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH)
+    #define FILE_PERMISSIONS        (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)
+
+    /* Directory handle cache */
+
+    typedef struct {
+        char path[PATH_BUFFER_SIZE];
+        int file;
+        uint32_t lastUsed;
+    } DR_cachedDirectory_t;
+
+    static uint32_t cacheCounter;
+
+    static bool cacheInitialised;
+
+    static DR_cachedDirectory_t cache[DIRECTORY_CACHE_SIZE];
+
+    /* Private functions */
+
+    static void makeDirectories(char *directory) {
+
+        for (char *separator = strchr(directory + 1, '/'); separator != NULL; separator = strchr(separator + 1, '/')) {
+
+            *separator = 0;
+
+            mkdir(directory, DIRECTORY_PERMISSIONS);
+
+            *separator = '/';
+
+        }
+
+        mkdir(directory, DIRECTORY_PERMISSIONS);
+
+    }
+
+    static void evictDirectory(int file) {
+
+        for (int32_t i = 0; i < DIRECTORY_CACHE_SIZE; i += 1) {
+
+            if (cache[i].file == file) {
+
+                close(cache[i].file);
+
+                cache[i].file = -1;
+
+                cache[i].path[0] = 0;
+
+                cache[i].lastUsed = 0;
+
+            }
+
+        }
+
+    }
+
+    static int openDirectory(char *directory) {
+
+        if (cacheInitialised == false) {
+
+            for (int32_t i = 0; i < DIRECTORY_CACHE_SIZE; i += 1) cache[i].file = -1;
+
+            cacheInitialised = true;
+
+        }
+
+        cacheCounter += 1;
+
+        DR_cachedDirectory_t *oldest = cache;
+
+        for (int32_t i = 0; i < DIRECTORY_CACHE_SIZE; i += 1) {
+
+            if (cache[i].file >= 0 && strcmp(cache[i].path, directory) == 0) {
+
+                cache[i].lastUsed = cacheCounter;
+
+                return cache[i].file;
+
+            }
+
+            if (cache[i].lastUsed < oldest->lastUsed) oldest = cache + i;
+
+        }
+
+        /* Directories are only created and opened when the path first changes */
+
+        int file = open(directory, O_RDONLY | O_DIRECTORY);
+
+        if (file < 0) {
+
+            makeDirectories(directory);
+
+            file = open(directory, O_RDONLY | O_DIRECTORY);
+
+        }
+
+        if (file < 0) return -1;
+
+        if (oldest->file >= 0) close(oldest->file);
+
+        snprintf(oldest->path, PATH_BUFFER_SIZE, "%s", directory);
+
+        oldest->file = file;
+
+        oldest->lastUsed = cacheCounter;
+
+        return file;
+
+    }
+
+    /* Public functions */
 
     bool Directory_exists(const char *path) {
 
         DIR *dir = opendir(path);
 
+        if (dir != NULL) closedir(dir);
+
         return dir != NULL;
 
     }
 
+    FILE *Directory_openFile(const char *path, const char *mode) {
+
+        static char directory[PATH_BUFFER_SIZE];
+
+        char *separator = strrchr(path, '/');
+
+        if (separator == NULL || separator == path || strlen(path) >= PATH_BUFFER_SIZE) return fopen(path, mode);
+
+        memcpy(directory, path, separator - path);
+
+        directory[separator - path] = 0;
+
+        int directoryFile = openDirectory(directory);
+
+        if (directoryFile < 0) return NULL;
+
+        /* Open relative to the cached directory handle */
+
+        int flags = mode[0] == 'w' ? O_CREAT | O_TRUNC : 0;
+
+        flags |= strchr(mode, '+') ? O_RDWR : mode[0] == 'r' ? O_RDONLY : O_WRONLY;
+
+        int file = openat(directoryFile, separator + 1, flags, FILE_PERMISSIONS);
+
+        /* Reopen the directory once by path if it has since been deleted, renamed or remounted */
+
+        if (file < 0 && (errno == ENOENT || errno == ESTALE)) {
+
+            evictDirectory(directoryFile);
+
+            directoryFile = openDirectory(directory);
+
+            if (directoryFile < 0) return NULL;
+
+            file = openat(directoryFile, separator + 1, flags, FILE_PERMISSIONS);
+
+        }
+
+        if (file < 0) return NULL;
+
+        FILE *stream = fdopen(file, mode);
+
+        if (stream == NULL) close(file);
+
+        return stream;
+
+    }
+
 #endif
\ No newline at end of file
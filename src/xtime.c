@@ -12,6 +12,7 @@
 
 #define NANOSECONDS_IN_MILLISECOND      1000000
 #define NANOSECONDS_IN_MICROSECOND      1000
+#define MICROSECONDS_IN_SECOND          1000000
 #define MILLISECONDS_IN_SECOND          1000
 #define SECONDS_IN_MINUTE               60
 
@@ -19,6 +20,8 @@
 
 #if defined(_WIN32) || defined(_WIN64)
 
+    #include <windows.h>
+
     #define timegm _mkgmtime
 
     uint32_t Time_getMicroseconds() {
@@ -45,6 +48,18 @@
 
     }
 
+    int64_t Time_getMonotonicMicroseconds() {
+
+        LARGE_INTEGER counter, frequency;
+
+        QueryPerformanceCounter(&counter);
+
+        QueryPerformanceFrequency(&frequency);
+
+        return (int64_t)(counter.QuadPart / frequency.QuadPart) * MICROSECONDS_IN_SECOND + (int64_t)(counter.QuadPart % frequency.QuadPart) * MICROSECONDS_IN_SECOND / frequency.QuadPart;
+
+    }
+
     void Time_gmTime(const time_t *timer, struct tm *buf) {
 
         gmtime_s(buf, timer);
@@ -77,6 +92,16 @@
 
     }
 
+    int64_t Time_getMonotonicMicroseconds(void) {
+
+        struct timespec time;
+
+        clock_gettime(CLOCK_MONOTONIC, &time);
+
+        return (int64_t)time.tv_sec * MICROSECONDS_IN_SECOND + (int64_t)time.tv_nsec / NANOSECONDS_IN_MICROSECOND;
+
+    }
+
     void Time_gmTime(const time_t *timer, struct tm *buf) {
 
         gmtime_r(timer, buf);
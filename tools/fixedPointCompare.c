@@ -0,0 +1,457 @@
+/****************************************************************************
+ * fixedPointCompare.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+/* Comparison of the fixed point capture and playback kernels against the double
+ * kernels selected by DSP DOUBLE. The kernels in main.c are private so they are
+ * reproduced here for a single channel. Build from the repository root with:
+ *
+ * gcc -I./inc/ ./tools/fixedPointCompare.c ./src/heterodyne.c ./src/biquad.c -o fixedPointCompare -lm
+ *
+ * and run with no arguments. The integer ratio decimators should be bit-exact.
+ * The interpolating kernels differ slightly as the fixed point position step is
+ * truncated, so the program exits with an error if the RMS difference from the
+ * double version rises above -60 dBFS.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "macros.h"
+#include "heterodyne.h"
+
+/* Constants matching main.c */
+
+#define MAXIMUM_SAMPLE_RATE                 384000
+#define PLAYBACK_SAMPLE_RATE                48000
+
+#define FIXED_SAMPLE_FRACTIONAL_BITS        8
+#define POSITION_FRACTIONAL_BITS            32
+#define WEIGHT_FRACTIONAL_BITS              16
+#define FIXED_POSITION_ONE                  (1LL << POSITION_FRACTIONAL_BITS)
+#define FIXED_SAMPLE_ONE                    (1 << FIXED_SAMPLE_FRACTIONAL_BITS)
+#define FIXED_WEIGHT_ONE                    (1LL << WEIGHT_FRACTIONAL_BITS)
+
+#define HETERODYNE_FREQUENCY                45000
+
+/* Test constants */
+
+#define INPUT_LENGTH                        384000
+#define OUTPUT_LENGTH                       (INPUT_LENGTH + 1)
+#define PLAYBACK_BLOCK_SIZE                 1024
+
+#define SINE_FREQUENCY                      1000.0
+#define SINE_AMPLITUDE                      30000.0
+
+#define INT16_SCALE                         32768.0
+#define MAXIMUM_ERROR_LEVEL                 -60.0
+
+#define NUMBER_OF_SAMPLE_RATES              8
+#define NUMBER_OF_INPUT_RATES               3
+
+#ifndef M_PI
+#define M_PI                                3.14159265358979323846
+#endif
+
+static int32_t sampleRates[NUMBER_OF_SAMPLE_RATES] = {8000, 16000, 32000, 48000, 96000, 192000, 250000, 384000};
+
+static int32_t inputRates[NUMBER_OF_INPUT_RATES] = {48000, 250000, 384000};
+
+/* Test buffers */
+
+static int16_t input[INPUT_LENGTH];
+
+static int16_t doubleOutput[OUTPUT_LENGTH];
+
+static int16_t fixedOutput[OUTPUT_LENGTH];
+
+/* Comparison result */
+
+typedef struct {
+    int32_t count;
+    int32_t maximumDifference;
+    double signalEnergy;
+    double errorEnergy;
+} FC_result_t;
+
+/* Private function to divide with rounding half away from zero to match round() */
+
+static inline int64_t roundedQuotient(int64_t numerator, int64_t denominator) {
+
+    return numerator >= 0 ? (numerator + denominator / 2) / denominator : -((denominator / 2 - numerator) / denominator);
+
+}
+
+static inline int16_t clampSample(int64_t sample) {
+
+    return (int16_t)MAX(INT16_MIN, MIN(INT16_MAX, sample));
+
+}
+
+/* Private functions to generate input */
+
+static void generateSine(void) {
+
+    for (int32_t i = 0; i < INPUT_LENGTH; i += 1) {
+
+        input[i] = (int16_t)round(SINE_AMPLITUDE * sin(2.0 * M_PI * SINE_FREQUENCY * (double)i / (double)MAXIMUM_SAMPLE_RATE));
+
+    }
+
+}
+
+static void generateNoise(void) {
+
+    srand(1);
+
+    for (int32_t i = 0; i < INPUT_LENGTH; i += 1) input[i] = (int16_t)(rand() % UINT16_MAX + INT16_MIN);
+
+}
+
+/* Capture kernels reproduced from main.c for one channel */
+
+static int32_t resampleDouble(int32_t inputRate, int32_t sampleRate) {
+
+    int32_t sampleRateDivider = inputRate / sampleRate;
+
+    double step = (double)inputRate / (double)(sampleRateDivider * sampleRate);
+
+    double scale = 1.0 / (double)sampleRateDivider;
+
+    double position = 0.0, currentSample = 0.0, nextSample = 0.0, accumulator = 0.0;
+
+    int32_t counter = 0, count = 0;
+
+    for (int32_t i = 0; i < INPUT_LENGTH; i += 1) {
+
+        currentSample = nextSample;
+
+        nextSample = input[i];
+
+        while (position < 1.0) {
+
+            accumulator += currentSample + position * (nextSample - currentSample);
+
+            counter += 1;
+
+            if (counter == sampleRateDivider) {
+
+                doubleOutput[count++] = clampSample((int64_t)round(accumulator * scale));
+
+                accumulator = 0.0;
+
+                counter = 0;
+
+            }
+
+            position += step;
+
+        }
+
+        position -= 1.0;
+
+    }
+
+    return count;
+
+}
+
+static int32_t resampleFixed(int32_t inputRate, int32_t sampleRate) {
+
+    int32_t sampleRateDivider = inputRate / sampleRate;
+
+    int64_t step = ((int64_t)inputRate << POSITION_FRACTIONAL_BITS) / ((int64_t)sampleRateDivider * sampleRate);
+
+    int64_t divisor = (int64_t)sampleRateDivider << WEIGHT_FRACTIONAL_BITS;
+
+    int64_t position = 0, accumulator = 0;
+
+    int32_t currentSample = 0, nextSample = 0, counter = 0, count = 0;
+
+    for (int32_t i = 0; i < INPUT_LENGTH; i += 1) {
+
+        currentSample = nextSample;
+
+        nextSample = input[i];
+
+        while (position < FIXED_POSITION_ONE) {
+
+            int64_t weight = position >> (POSITION_FRACTIONAL_BITS - WEIGHT_FRACTIONAL_BITS);
+
+            accumulator += currentSample * FIXED_WEIGHT_ONE + weight * (nextSample - currentSample);
+
+            counter += 1;
+
+            if (counter == sampleRateDivider) {
+
+                fixedOutput[count++] = clampSample(roundedQuotient(accumulator, divisor));
+
+                accumulator = 0;
+
+                counter = 0;
+
+            }
+
+            position += step;
+
+        }
+
+        position -= FIXED_POSITION_ONE;
+
+    }
+
+    return count;
+
+}
+
+static int32_t decimateDouble(int32_t ratio) {
+
+    double accumulator = 0.0;
+
+    int32_t count = 0;
+
+    for (int32_t i = 0; i < INPUT_LENGTH; i += 1) {
+
+        accumulator += input[i];
+
+        if ((i + 1) % ratio == 0) {
+
+            doubleOutput[count++] = clampSample((int64_t)round(accumulator * (1.0 / (double)ratio)));
+
+            accumulator = 0.0;
+
+        }
+
+    }
+
+    return count;
+
+}
+
+static int32_t decimateFixed(int32_t ratio) {
+
+    int64_t accumulator = 0;
+
+    int32_t count = 0;
+
+    for (int32_t i = 0; i < INPUT_LENGTH; i += 1) {
+
+        accumulator += input[i];
+
+        if ((i + 1) % ratio == 0) {
+
+            fixedOutput[count++] = clampSample(roundedQuotient(accumulator, ratio));
+
+            accumulator = 0;
+
+        }
+
+    }
+
+    return count;
+
+}
+
+/* Playback kernels reproduced from main.c reading the input as the capture buffer */
+
+static int32_t playbackDouble(int32_t sampleRate, bool heterodyne) {
+
+    int32_t sampleRateDivider = MAXIMUM_SAMPLE_RATE / PLAYBACK_SAMPLE_RATE;
+
+    double step = (double)sampleRate / (double)MAXIMUM_SAMPLE_RATE;
+
+    double position = 0.0, currentSample = 0.0, nextSample = 0.0;
+
+    int32_t readIndex = 0, count = 0;
+
+    if (heterodyne) Heterodyne_initialise(sampleRate, HETERODYNE_FREQUENCY);
+
+    while (readIndex < INPUT_LENGTH - 1 && count < OUTPUT_LENGTH) {
+
+        double accumulator = 0.0;
+
+        for (int32_t j = 0; j < sampleRateDivider; j += 1) {
+
+            double sample = currentSample + position * (nextSample - currentSample);
+
+            accumulator += heterodyne ? Heterodyne_nextOutput(sample) : sample;
+
+            position += step;
+
+            if (position >= 1.0) {
+
+                currentSample = nextSample;
+
+                nextSample = input[readIndex++];
+
+                position -= 1.0;
+
+            }
+
+        }
+
+        doubleOutput[count++] = clampSample((int64_t)round(accumulator / (double)sampleRateDivider));
+
+        if (heterodyne && count % PLAYBACK_BLOCK_SIZE == 0) Heterodyne_normalise();
+
+    }
+
+    return count;
+
+}
+
+static int32_t playbackFixed(int32_t sampleRate, bool heterodyne) {
+
+    int32_t sampleRateDivider = MAXIMUM_SAMPLE_RATE / PLAYBACK_SAMPLE_RATE;
+
+    int64_t step = ((int64_t)sampleRate << POSITION_FRACTIONAL_BITS) / MAXIMUM_SAMPLE_RATE;
+
+    int64_t position = 0;
+
+    int32_t currentSample = 0, nextSample = 0, readIndex = 0, count = 0;
+
+    if (heterodyne) Heterodyne_initialise(sampleRate, HETERODYNE_FREQUENCY);
+
+    while (readIndex < INPUT_LENGTH - 1 && count < OUTPUT_LENGTH) {
+
+        int64_t accumulator = 0;
+
+        for (int32_t j = 0; j < sampleRateDivider; j += 1) {
+
+            int32_t weight = (int32_t)(position >> (POSITION_FRACTIONAL_BITS - WEIGHT_FRACTIONAL_BITS));
+
+            int32_t sample = currentSample * FIXED_SAMPLE_ONE + (int32_t)(((int64_t)weight * (nextSample - currentSample)) >> (WEIGHT_FRACTIONAL_BITS - FIXED_SAMPLE_FRACTIONAL_BITS));
+
+            accumulator += heterodyne ? Heterodyne_nextFixedOutput(sample) : sample;
+
+            position += step;
+
+            if (position >= FIXED_POSITION_ONE) {
+
+                currentSample = nextSample;
+
+                nextSample = input[readIndex++];
+
+                position -= FIXED_POSITION_ONE;
+
+            }
+
+        }
+
+        fixedOutput[count++] = clampSample(roundedQuotient(accumulator, (int64_t)sampleRateDivider * FIXED_SAMPLE_ONE));
+
+        if (heterodyne && count % PLAYBACK_BLOCK_SIZE == 0) Heterodyne_normaliseFixed();
+
+    }
+
+    return count;
+
+}
+
+/* Private functions to compare and report the outputs */
+
+static FC_result_t compareOutputs(int32_t doubleCount, int32_t fixedCount) {
+
+    /* The truncated fixed point step can leave one extra output at the end of the input */
+
+    FC_result_t result = {.count = MIN(doubleCount, fixedCount)};
+
+    for (int32_t i = 0; i < result.count; i += 1) {
+
+        int32_t difference = abs(doubleOutput[i] - fixedOutput[i]);
+
+        result.maximumDifference = MAX(result.maximumDifference, difference);
+
+        result.signalEnergy += (double)doubleOutput[i] * doubleOutput[i];
+
+        result.errorEnergy += (double)difference * difference;
+
+    }
+
+    return result;
+
+}
+
+static bool reportResult(const char *name, const char *inputName, int32_t inputRate, int32_t sampleRate, FC_result_t result, bool exact) {
+
+    if (result.errorEnergy == 0.0) {
+
+        printf("%-12s %-6s %6d Hz -> %6d Hz - %6d samples - bit-exact\n", name, inputName, inputRate, sampleRate, result.count);
+
+        return true;
+
+    }
+
+    double errorLevel = 10.0 * log10(result.errorEnergy / (double)result.count / (INT16_SCALE * INT16_SCALE));
+
+    printf("%-12s %-6s %6d Hz -> %6d Hz - %6d samples - maximum difference %d LSB - error %.1f dBFS\n", name, inputName, inputRate, sampleRate, result.count, result.maximumDifference, errorLevel);
+
+    return exact == false && errorLevel < MAXIMUM_ERROR_LEVEL;
+
+}
+
+/* Main function */
+
+int main(void) {
+
+    bool success = true;
+
+    for (int32_t signal = 0; signal < 2; signal += 1) {
+
+        const char *inputName = signal == 0 ? "sine" : "noise";
+
+        if (signal == 0) generateSine(); else generateNoise();
+
+        /* Capture at every valid sample rate from each input rate */
+
+        for (int32_t i = 0; i < NUMBER_OF_INPUT_RATES; i += 1) {
+
+            for (int32_t j = 0; j < NUMBER_OF_SAMPLE_RATES; j += 1) {
+
+                int32_t inputRate = inputRates[i];
+
+                int32_t sampleRate = sampleRates[j];
+
+                if (sampleRate > inputRate) continue;
+
+                if (inputRate % sampleRate == 0) {
+
+                    success &= reportResult("decimate", inputName, inputRate, sampleRate, compareOutputs(decimateDouble(inputRate / sampleRate), decimateFixed(inputRate / sampleRate)), true);
+
+                } else {
+
+                    success &= reportResult("resample", inputName, inputRate, sampleRate, compareOutputs(resampleDouble(inputRate, sampleRate), resampleFixed(inputRate, sampleRate)), false);
+
+                }
+
+            }
+
+        }
+
+        /* Playback at every valid sample rate */
+
+        for (int32_t j = 0; j < NUMBER_OF_SAMPLE_RATES; j += 1) {
+
+            int32_t sampleRate = sampleRates[j];
+
+            success &= reportResult("playback", inputName, sampleRate, PLAYBACK_SAMPLE_RATE, compareOutputs(playbackDouble(sampleRate, false), playbackFixed(sampleRate, false)), false);
+
+            if (sampleRate <= 2 * HETERODYNE_FREQUENCY) continue;
+
+            success &= reportResult("heterodyne", inputName, sampleRate, PLAYBACK_SAMPLE_RATE, compareOutputs(playbackDouble(sampleRate, true), playbackFixed(sampleRate, true)), false);
+
+        }
+
+    }
+
+    puts(success ? "All fixed point kernels match the double path." : "[ERROR] Fixed point kernels differ from the double path.");
+
+    return success ? 0 : 1;
+
+}
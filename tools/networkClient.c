@@ -0,0 +1,323 @@
+/****************************************************************************
+ * networkClient.c
+ * openacousticdevices.info
+ * October 2026
+ *****************************************************************************/
+
+/* Test client for the TCPSERVER and UDPSERVER options. It subscribes, checks the
+ * sequence numbers and timestamps of the packets it receives and prints a summary
+ * each second. Build on macOS or Linux with:
+ *
+ * gcc ./tools/networkClient.c -o networkClient
+ *
+ * and run against a local server with:
+ *
+ * ./networkClient udp 5004
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+/* Protocol constants matching network.c */
+
+#define SUBSCRIBE_MESSAGE               "SUBSCRIBE "
+#define CHALLENGE_MESSAGE               "NONCE "
+#define UNSUBSCRIBE_MESSAGE             "STOP"
+
+#define RTP_HEADER_SIZE                 12
+#define RTP_EXTENSION_SIZE              16
+#define TCP_FRAMING_SIZE                2
+
+#define RTP_VERSION_WITH_EXTENSION      0x90
+
+/* Client constants */
+
+#define DEFAULT_ADDRESS                 "127.0.0.1"
+#define DEFAULT_DURATION                10
+
+#define PACKET_BUFFER_SIZE              65536
+#define MESSAGE_SIZE                    64
+
+#define RECEIVE_TIMEOUT                 100000
+#define REFRESH_INTERVAL                10
+#define CHALLENGE_TIMEOUT               5
+
+#define MILLISECONDS_IN_SECOND          1000
+
+/* Packet statistics */
+
+typedef struct {
+    int64_t packets;
+    int64_t samples;
+    int64_t lostPackets;
+    int64_t timestampErrors;
+    uint16_t nextSequence;
+    uint32_t nextTimestamp;
+    uint32_t sampleRate;
+    int64_t time;
+} NC_statistics_t;
+
+/* Private functions to read big endian fields */
+
+static inline uint16_t readUint16(uint8_t *buffer) {
+
+    return (uint16_t)(buffer[0] << 8 | buffer[1]);
+
+}
+
+static inline uint32_t readUint32(uint8_t *buffer) {
+
+    return (uint32_t)readUint16(buffer) << 16 | readUint16(buffer + 2);
+
+}
+
+/* Private function to check each packet against the previous one */
+
+static bool processPacket(NC_statistics_t *statistics, uint8_t *packet, int32_t length) {
+
+    if (length < RTP_HEADER_SIZE + RTP_EXTENSION_SIZE || packet[0] != RTP_VERSION_WITH_EXTENSION) return false;
+
+    uint16_t sequence = readUint16(packet + 2);
+
+    uint32_t timestamp = readUint32(packet + 4);
+
+    uint32_t sampleRate = readUint32(packet + RTP_HEADER_SIZE + 4);
+
+    int64_t time = (int64_t)readUint32(packet + RTP_HEADER_SIZE + 8) << 32 | readUint32(packet + RTP_HEADER_SIZE + 12);
+
+    int32_t numberOfSamples = (length - RTP_HEADER_SIZE - RTP_EXTENSION_SIZE) / 2;
+
+    /* The server skips the sequence forward when it drops samples for a slow client */
+
+    if (statistics->packets > 0) {
+
+        statistics->lostPackets += (uint16_t)(sequence - statistics->nextSequence);
+
+        bool continuous = sequence == statistics->nextSequence && sampleRate == statistics->sampleRate;
+
+        if (continuous && timestamp != statistics->nextTimestamp) statistics->timestampErrors += 1;
+
+    }
+
+    statistics->packets += 1;
+
+    statistics->samples += numberOfSamples;
+
+    statistics->nextSequence = sequence + 1;
+
+    statistics->nextTimestamp = timestamp + numberOfSamples;
+
+    statistics->sampleRate = sampleRate;
+
+    statistics->time = time;
+
+    return true;
+
+}
+
+static void printStatistics(NC_statistics_t *statistics) {
+
+    time_t seconds = (time_t)(statistics->time / MILLISECONDS_IN_SECOND);
+
+    struct tm *time = gmtime(&seconds);
+
+    printf("%02d:%02d:%02d.%03d - %u Hz - %lld packets - %lld samples - %lld lost packets - %lld timestamp errors\n", time->tm_hour, time->tm_min, time->tm_sec, (int32_t)(statistics->time % MILLISECONDS_IN_SECOND), statistics->sampleRate, (long long)statistics->packets, (long long)statistics->samples, (long long)statistics->lostPackets, (long long)statistics->timestampErrors);
+
+    fflush(stdout);
+
+}
+
+/* Private functions to subscribe over UDP by echoing the nonce sent by the server */
+
+static void sendMessage(int clientSocket, const char *message) {
+
+    send(clientSocket, message, strlen(message), 0);
+
+}
+
+static bool subscribe(int clientSocket, char *subscribeMessage) {
+
+    static char message[MESSAGE_SIZE + 1];
+
+    /* The request is padded to the length of the challenge which the server will not exceed */
+
+    snprintf(subscribeMessage, MESSAGE_SIZE, "%s%016llx", SUBSCRIBE_MESSAGE, 0ULL);
+
+    time_t startTime = time(NULL);
+
+    while (time(NULL) - startTime < CHALLENGE_TIMEOUT) {
+
+        sendMessage(clientSocket, subscribeMessage);
+
+        ssize_t length = recv(clientSocket, message, MESSAGE_SIZE, 0);
+
+        if (length <= 0) continue;
+
+        message[length] = 0;
+
+        if (strncmp(message, CHALLENGE_MESSAGE, strlen(CHALLENGE_MESSAGE)) != 0) continue;
+
+        snprintf(subscribeMessage, MESSAGE_SIZE, "%s%s", SUBSCRIBE_MESSAGE, message + strlen(CHALLENGE_MESSAGE));
+
+        sendMessage(clientSocket, subscribeMessage);
+
+        return true;
+
+    }
+
+    return false;
+
+}
+
+/* Private function to read one framed packet from the TCP stream */
+
+static bool receiveAll(int clientSocket, uint8_t *buffer, int32_t length, time_t endTime) {
+
+    int32_t received = 0;
+
+    while (received < length && time(NULL) < endTime) {
+
+        ssize_t count = recv(clientSocket, buffer + received, length - received, 0);
+
+        if (count == 0) return false;
+
+        if (count > 0) received += (int32_t)count;
+
+    }
+
+    return received == length;
+
+}
+
+/* Main function */
+
+int main(int argc, char **argv) {
+
+    static uint8_t packet[PACKET_BUFFER_SIZE];
+
+    static char subscribeMessage[MESSAGE_SIZE];
+
+    if (argc < 3 || (strcmp(argv[1], "udp") != 0 && strcmp(argv[1], "tcp") != 0)) {
+
+        printf("Usage: %s udp|tcp <port> [address] [duration]\n", argv[0]);
+
+        return 1;
+
+    }
+
+    bool useTCP = strcmp(argv[1], "tcp") == 0;
+
+    int32_t duration = argc > 4 ? atoi(argv[4]) : DEFAULT_DURATION;
+
+    struct sockaddr_in address;
+
+    memset(&address, 0, sizeof(struct sockaddr_in));
+
+    address.sin_family = AF_INET;
+    address.sin_port = htons(atoi(argv[2]));
+
+    if (inet_pton(AF_INET, argc > 3 ? argv[3] : DEFAULT_ADDRESS, &address.sin_addr) != 1) {
+
+        puts("[ERROR] Could not parse address.");
+
+        return 1;
+
+    }
+
+    /* Connect and subscribe */
+
+    int clientSocket = socket(AF_INET, useTCP ? SOCK_STREAM : SOCK_DGRAM, 0);
+
+    struct timeval timeout = {.tv_sec = 0, .tv_usec = RECEIVE_TIMEOUT};
+
+    setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    if (clientSocket < 0 || connect(clientSocket, (struct sockaddr*)&address, sizeof(struct sockaddr_in)) != 0) {
+
+        puts("[ERROR] Could not connect to server.");
+
+        return 1;
+
+    }
+
+    if (useTCP == false && subscribe(clientSocket, subscribeMessage) == false) {
+
+        puts("[ERROR] Server did not send a challenge.");
+
+        return 1;
+
+    }
+
+    /* Receive packets and print a summary each second */
+
+    NC_statistics_t statistics;
+
+    memset(&statistics, 0, sizeof(NC_statistics_t));
+
+    time_t startTime = time(NULL);
+
+    time_t lastRefresh = startTime;
+
+    time_t lastSummary = startTime;
+
+    bool success = true;
+
+    while (time(NULL) - startTime < duration) {
+
+        if (useTCP) {
+
+            if (receiveAll(clientSocket, packet, TCP_FRAMING_SIZE, startTime + duration) == false) break;
+
+            int32_t length = readUint16(packet);
+
+            if (receiveAll(clientSocket, packet, length, startTime + duration) == false) break;
+
+            success &= processPacket(&statistics, packet, length);
+
+        } else {
+
+            ssize_t length = recv(clientSocket, packet, PACKET_BUFFER_SIZE, 0);
+
+            if (length > 0) processPacket(&statistics, packet, (int32_t)length);
+
+            /* Refresh the subscription well within the server timeout */
+
+            if (time(NULL) - lastRefresh >= REFRESH_INTERVAL) {
+
+                sendMessage(clientSocket, subscribeMessage);
+
+                lastRefresh = time(NULL);
+
+            }
+
+        }
+
+        if (time(NULL) != lastSummary && statistics.packets > 0) {
+
+            printStatistics(&statistics);
+
+            lastSummary = time(NULL);
+
+        }
+
+    }
+
+    if (useTCP == false) sendMessage(clientSocket, UNSUBSCRIBE_MESSAGE);
+
+    close(clientSocket);
+
+    if (statistics.packets == 0) puts("[ERROR] No packets received.");
+
+    return success && statistics.packets > 0 && statistics.timestampErrors == 0 ? 0 : 1;
+
+}